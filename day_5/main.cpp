@@ -3,9 +3,11 @@
 #include <filesystem>
 #include <fstream>
 #include <iostream>
+#include <iterator>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <unordered_map>
 #include <utility>
 #include <vector>
 
@@ -100,33 +102,231 @@ void order_update(std::vector<uint32_t>& update,
         order_update(update, ordering_rules);
 }
 
+/**
+ * @brief Kahn's algorithm over the rules between pages of the update, order_update never
+ * terminates on such an update.
+ */
+[[nodiscard]] bool
+    has_ordering_cycle(const std::vector<uint32_t>& update,
+                       const std::vector<std::pair<uint32_t, uint32_t>>& ordering_rules) {
+    std::unordered_map<uint32_t, std::size_t> incoming;
+    std::vector<std::pair<uint32_t, uint32_t>> relevant;
+    for(const uint32_t page: update)
+        incoming.emplace(page, 0U);
+    for(const std::pair<uint32_t, uint32_t>& rule: ordering_rules) {
+        if(rule.first != rule.second && incoming.contains(rule.first)
+           && incoming.contains(rule.second)) {
+            relevant.push_back(rule);
+            ++incoming[rule.second];
+        }
+    }
+
+    std::vector<uint32_t> ready;
+    for(const auto& [page, count]: incoming) {
+        if(count == 0U)
+            ready.push_back(page);
+    }
+    std::size_t resolved {};
+    while(!ready.empty()) {
+        const uint32_t page = ready.back();
+        ready.pop_back();
+        ++resolved;
+        for(const std::pair<uint32_t, uint32_t>& rule: relevant) {
+            if(rule.first == page && --incoming[rule.second] == 0U)
+                ready.push_back(rule.second);
+        }
+    }
+    return resolved != incoming.size();
+}
+
+/**
+ * @brief Keeps the ordered/unordered state of every update and both middle page sums up to
+ * date while ordering rules are added or removed.
+ *
+ * A rule X|Y can only change the outcome for updates that contain both X and Y, so an inverted
+ * index from page to the updates containing it is used to revalidate just those.
+ */
+class update_index {
+  public:
+    update_index(std::vector<std::pair<uint32_t, uint32_t>> ordering_rules,
+                 std::vector<std::vector<uint32_t>> updates) :
+        ordering_rules_(std::move(ordering_rules)),
+        updates_(std::move(updates)),
+        states_(updates_.size()) {
+        for(std::size_t update_i = 0U; update_i < updates_.size(); ++update_i) {
+            for(const uint32_t page: updates_[update_i]) {
+                std::vector<std::size_t>& containing = pages_to_updates_[page];
+                // updates are visited in ascending order, so the lists stay sorted
+                if(containing.empty() || containing.back() != update_i)
+                    containing.push_back(update_i);
+            }
+            revalidate(update_i);
+        }
+    }
+
+    /**
+     * @return false if the rule would make the pages of an update impossible to order, the rule
+     * is not added then
+     */
+    bool add_rule(const uint32_t x, const uint32_t y) {
+        const std::pair<uint32_t, uint32_t> rule {x, y};
+        if(std::find(ordering_rules_.cbegin(), ordering_rules_.cend(), rule)
+           != ordering_rules_.cend())
+            return true;
+        if(x == y)
+            return false;
+        ordering_rules_.push_back(rule);
+        const std::vector<std::size_t> affected = affected_updates(x, y);
+        for(const std::size_t update_i: affected) {
+            if(has_ordering_cycle(updates_[update_i], ordering_rules_)) {
+                ordering_rules_.pop_back();
+                return false;
+            }
+        }
+        for(const std::size_t update_i: affected)
+            revalidate(update_i);
+        return true;
+    }
+
+    void remove_rule(const uint32_t x, const uint32_t y) {
+        const std::pair<uint32_t, uint32_t> rule {x, y};
+        auto it = std::find(ordering_rules_.begin(), ordering_rules_.end(), rule);
+        if(it == ordering_rules_.end())
+            return;
+        ordering_rules_.erase(it);
+        for(const std::size_t update_i: affected_updates(x, y))
+            revalidate(update_i);
+    }
+
+    [[nodiscard]] std::size_t ordered_updates() const {
+        return ordered_updates_;
+    }
+
+    [[nodiscard]] std::size_t total_updates() const {
+        return updates_.size();
+    }
+
+    [[nodiscard]] uint64_t sum_middle_page_numbers() const {
+        return sum_middle_page_numbers_;
+    }
+
+    [[nodiscard]] uint64_t sum_middle_page_numbers_reordered() const {
+        return sum_middle_page_numbers_reordered_;
+    }
+
+  private:
+    struct update_state {
+        bool validated;         //!< contribution has been added to the sums
+        bool ordered;           //!< update already satisfies all rules
+        uint32_t middle_page;   //!< middle page after ordering
+    };
+
+    /**
+     * @return indices of the updates containing both pages
+     */
+    [[nodiscard]] std::vector<std::size_t> affected_updates(const uint32_t x,
+                                                            const uint32_t y) const {
+        const auto it_x = pages_to_updates_.find(x);
+        const auto it_y = pages_to_updates_.find(y);
+        std::vector<std::size_t> affected;
+        if(it_x == pages_to_updates_.end() || it_y == pages_to_updates_.end())
+            return affected;
+        std::set_intersection(it_x->second.cbegin(),
+                              it_x->second.cend(),
+                              it_y->second.cbegin(),
+                              it_y->second.cend(),
+                              std::back_inserter(affected));
+        return affected;
+    }
+
+    void revalidate(const std::size_t update_i) {
+        update_state& state = states_[update_i];
+        // drop the previous contribution before recomputing it
+        if(state.validated) {
+            if(state.ordered) {
+                --ordered_updates_;
+                sum_middle_page_numbers_ -= state.middle_page;
+            } else {
+                sum_middle_page_numbers_reordered_ -= state.middle_page;
+            }
+        }
+
+        const std::vector<uint32_t>& update = updates_[update_i];
+        state.validated = true;
+        state.ordered = is_update_ordered(update, ordering_rules_);
+        if(state.ordered) {
+            state.middle_page = update.at(update.size() / 2);
+            ++ordered_updates_;
+            sum_middle_page_numbers_ += state.middle_page;
+        } else {
+            std::vector<uint32_t> reordered = update;
+            order_update(reordered, ordering_rules_);
+            state.middle_page = reordered.at(reordered.size() / 2);
+            sum_middle_page_numbers_reordered_ += state.middle_page;
+        }
+    }
+
+    std::vector<std::pair<uint32_t, uint32_t>> ordering_rules_;
+    std::vector<std::vector<uint32_t>> updates_;
+    std::vector<update_state> states_;
+    std::unordered_map<uint32_t, std::vector<std::size_t>> pages_to_updates_;
+    std::size_t ordered_updates_ {};
+    uint64_t sum_middle_page_numbers_ {};
+    uint64_t sum_middle_page_numbers_reordered_ {};
+};
+
+void print_sums(const update_index& index) {
+    std::cout << index.ordered_updates() << "/" << index.total_updates()
+              << " updates are ordered\n";
+    std::cout << "Sum of middle page numbers: " << index.sum_middle_page_numbers() << "\n";
+    std::cout << "Sum of middle page numbers: " << index.sum_middle_page_numbers_reordered()
+              << "\n";
+}
+
+/**
+ * @brief Applies rule changes from a file with one change per line, "+X|Y" adds and "-X|Y"
+ * removes a rule, printing the updated sums after every change.
+ */
+void apply_rule_changes(update_index& index, const std::filesystem::path& path) {
+    const auto& working_path = std::filesystem::canonical(path);
+    std::ifstream ifs {working_path};
+    if(!ifs.good())
+        throw std::runtime_error("Unable to open file " + path.string());
+
+    std::string line;
+    while(std::getline(ifs, line)) {
+        const std::string::size_type pos = line.find("|");
+        if(line.size() < 2U || pos == std::string::npos)
+            continue;
+
+        const uint32_t x = std::stoul(line.substr(1U, pos - 1U));
+        const uint32_t y = std::stoul(line.substr(pos + 1U));
+        if(line[0] == '+') {
+            if(!index.add_rule(x, y)) {
+                std::cout << "\n[ERROR]: " << line
+                          << " contradicts the existing rules of an update, skipped\n";
+                continue;
+            }
+        } else if(line[0] == '-') {
+            index.remove_rule(x, y);
+        } else {
+            continue;
+        }
+        std::cout << "\nAfter " << line << ":\n";
+        print_sums(index);
+    }
+}
+
 int main(int argc, char** argv) {
     if(argc < 2) {
         std::cout << "invalid number of arguments\n";
         return 1;
     }
     const std::filesystem::path path {argv[1]};
-    const auto& orderings = read_orderings(path);
-    const auto& updates = read_updates(path);
-
-    std::vector<std::vector<uint32_t>> unordered_updates;
-    std::size_t ordered_updates {};
-    uint64_t sum_middle_page_numbers {};
-    std::for_each(updates.cbegin(), updates.cend(), [&](const std::vector<uint32_t>& update) {
-        if(is_update_ordered(update, orderings)) {
-            ++ordered_updates;
-            sum_middle_page_numbers += update.at(update.size() / 2);
-        } else {
-            unordered_updates.push_back(update);
-        }
-    });
-    std::cout << ordered_updates << "/" << updates.size() << " updates are ordered\n";
-    std::cout << "Sum of middle page numbers: " << sum_middle_page_numbers << "\n";
+    update_index index {read_orderings(path), read_updates(path)};
+    print_sums(index);
 
-    uint64_t sum_middle_page_numbers_reordered {};
-    for(auto& unordered_update: unordered_updates) {
-        order_update(unordered_update, orderings);
-        sum_middle_page_numbers_reordered += unordered_update.at(unordered_update.size() / 2);
-    }
-    std::cout << "Sum of middle page numbers: " << sum_middle_page_numbers_reordered << "\n";
+    // optional file with rule changes that are applied incrementally
+    if(argc > 2)
+        apply_rule_changes(index, argv[2]);
 }
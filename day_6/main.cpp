@@ -1,20 +1,90 @@
 #include <algorithm>
 #include <array>
+#include <atomic>
 #include <cstddef>
 #include <cstdint>
 #include <filesystem>
 #include <format>
 #include <fstream>
+#include <functional>
 #include <iostream>
+#include <limits>
 #include <optional>
 #include <stdexcept>
 #include <string>
 #include <vector>
 
 #include <sys/types.h>
+#include <tbb/blocked_range.h>
+#include <tbb/enumerable_thread_specific.h>
+#include <tbb/parallel_reduce.h>
 
-enum class field { empty = 0, obstacle = 1, guard = 2, invalid = 3 };
-using mat = std::vector<std::vector<field>>;
+enum class field : uint8_t { empty = 0, obstacle = 1, guard = 2, invalid = 3 };
+
+/**
+ * @brief Flat, row-major lab map storing every field in 2 bits.
+ *
+ * The map is surrounded by a border of field::invalid, so looking one step past the edge of the
+ * map needs no separate bounds check.
+ */
+class grid {
+  public:
+    explicit grid(const std::vector<std::vector<field>>& rows) :
+        width_(rows.empty() ? 0 : rows[0].size()),
+        height_(rows.size()),
+        padded_width_(width_ + 2),
+        cells_((static_cast<std::size_t>(padded_width_) * (height_ + 2) + cells_per_word - 1U)
+                   / cells_per_word,
+               ~uint64_t {}) {
+        for(int32_t m = 0; m < height_; ++m) {
+            const int32_t cols = std::min<int32_t>(width_, rows[m].size());
+            for(int32_t n = 0; n < cols; ++n)
+                set(m, n, rows[m][n]);
+        }
+    }
+
+    /**
+     * @brief Field at row m and column n, field::invalid for the border around the map.
+     *
+     * @param m row in [-1, height]
+     * @param n column in [-1, width]
+     */
+    [[nodiscard]] field at(const int32_t m, const int32_t n) const {
+        const std::size_t i = index(m, n);
+        return static_cast<field>((cells_[i / cells_per_word] >> shift(i)) & field_mask);
+    }
+
+    void set(const int32_t m, const int32_t n, const field f) {
+        const std::size_t i = index(m, n);
+        uint64_t& word = cells_[i / cells_per_word];
+        word = (word & ~(field_mask << shift(i))) | (static_cast<uint64_t>(f) << shift(i));
+    }
+
+    [[nodiscard]] int32_t width() const {
+        return width_;
+    }
+
+    [[nodiscard]] int32_t height() const {
+        return height_;
+    }
+
+  private:
+    static constexpr std::size_t cells_per_word = 32U;
+    static constexpr uint64_t field_mask = 0x3U;
+
+    [[nodiscard]] std::size_t index(const int32_t m, const int32_t n) const {
+        return static_cast<std::size_t>(m + 1) * padded_width_ + (n + 1);
+    }
+
+    [[nodiscard]] static uint32_t shift(const std::size_t i) {
+        return (i % cells_per_word) * 2U;
+    }
+
+    int32_t width_;
+    int32_t height_;
+    int32_t padded_width_;
+    std::vector<uint64_t> cells_;
+};
 
 std::vector<field> process_line(const std::string& s) {
     std::vector<field> line;
@@ -36,19 +106,19 @@ std::vector<field> process_line(const std::string& s) {
     return line;
 }
 
-mat get_map(const std::filesystem::path& path) {
+grid get_map(const std::filesystem::path& path) {
     const std::filesystem::path ws_path = std::filesystem::canonical(path);
     std::ifstream ifs {ws_path};
 
     if(!ifs.good())
         throw std::runtime_error("Could not open file " + ws_path.string());
 
-    mat map;
+    std::vector<std::vector<field>> rows;
     std::string line;
     while(std::getline(ifs, line)) {
-        map.emplace_back(process_line(line));
+        rows.emplace_back(process_line(line));
     }
-    return map;
+    return grid {rows};
 }
 
 struct location {
@@ -58,6 +128,8 @@ struct location {
     int32_t m;        //!< row
     int32_t n;        //!< column
     direction dir;    //!< direction faced
+
+    bool operator==(const location& rhs) const = default;
 };
 template<>
 struct std::formatter<location::direction> : std::formatter<std::string> {
@@ -109,9 +181,21 @@ struct std::formatter<states> : std::formatter<std::string> {
 
 class guard {
   public:
-    guard(const mat& map, const location& start_position) :
-        map_(map), width_(map_[0].size()), height_(map.size()), pos_(start_position) {
-        visited_locations_.push_back({start_position, 1U});
+    /**
+     * @param extra_obstacle obstacle overlaid on the map, so candidates can be checked without
+     * modifying a shared map
+     */
+    guard(const grid& map,
+          const location& start_position,
+          const std::optional<location> extra_obstacle = std::nullopt) :
+        map_(map),
+        width_(map.width()),
+        height_(map.height()),
+        pos_(start_position),
+        extra_obstacle_(extra_obstacle),
+        visited_states_(static_cast<std::size_t>(width_) * height_ * 4U, false),
+        visited_cells_(static_cast<std::size_t>(width_) * height_, false) {
+        update_locations_visisted(start_position);
     }
 
     bool move() {
@@ -143,13 +227,11 @@ class guard {
                 state_ = states::standby;
                 return false;
             }
-            if(is_in_bounds(new_location)) {
-                // std::cout << std::format("{}\n", new_location);
-                pos_ = new_location;
-                update_locations_visisted();
-                return true;
-            }
-            return false;
+            // std::cout << std::format("{}\n", new_location);
+            const location previous_location = pos_;
+            pos_ = new_location;
+            update_locations_visisted(previous_location);
+            return true;
         }
         case states::change_direction: {
             // std::cout << std::format("STATE CHANGE {}\n", state_, states::standby);
@@ -163,11 +245,20 @@ class guard {
     }
 
     uint32_t num_locations_visited() const {
-        return get_unique_locations().size();
+        return unique_locations_.size();
     }
 
     [[nodiscard]] std::vector<location> visited_locations() const {
-        return get_unique_locations();
+        return unique_locations_;
+    }
+
+    /**
+     * @brief State of the guard right before it first entered each of the visited_locations,
+     * i.e. standing on the previous cell and facing the location. The start cell maps to the
+     * start position.
+     */
+    [[nodiscard]] std::vector<location> entry_locations() const {
+        return entry_locations_;
     }
 
     [[nodiscard]] bool was_loop_detected() const {
@@ -175,131 +266,423 @@ class guard {
     }
 
   private:
-    std::vector<location> get_unique_locations() const {
-        std::vector<location> unique_locations;
-        unique_locations.reserve(visited_locations_.size());
-        for(const auto& visited: visited_locations_) {
-            if(std::find_if(unique_locations.begin(),
-                            unique_locations.end(),
-                            [&](const location& pos) {
-                                return (pos.m == visited.first.m) && (pos.n == visited.first.n);
-                            })
-               == unique_locations.end())
-                unique_locations.push_back(visited.first);
-        }
-        return unique_locations;
+    [[nodiscard]] std::size_t cell_index(const location& l) const {
+        return static_cast<std::size_t>(l.m) * width_ + l.n;
+    }
+
+    [[nodiscard]] std::size_t state_index(const location& l) const {
+        return cell_index(l) * 4U + static_cast<uint32_t>(l.dir);
     }
 
     [[nodiscard]] bool was_already_visited(const location& l) {
-        for(const auto& visited: visited_locations_) {
-            if((visited.first.m == l.m) && (visited.first.n == l.n)
-               && (visited.first.dir == l.dir)) {
-                loop_detected_ = true;
-                return true;
-            }
+        if(visited_states_[state_index(l)]) {
+            loop_detected_ = true;
+            return true;
         }
         return false;
     }
 
-    void update_locations_visisted() {
-        if(auto it = std::find_if(visited_locations_.begin(),
-                                  visited_locations_.end(),
-                                  [&](const std::pair<location, uint32_t>& visited) {
-                                      return (visited.first.m == pos_.m)
-                                             && (visited.first.n == pos_.n)
-                                             && (visited.first.dir == pos_.dir);
-                                  });
-           it != visited_locations_.end()) {
-            // if we've been at that location with a fitting direction, update the counter
-            ++(it->second);
-        } else {
-            // if not add the location to the visited places
-            visited_locations_.emplace_back(std::pair<location, uint32_t> {
-                location {.m = pos_.m, .n = pos_.n, .dir = pos_.dir}, 1U});
+    void update_locations_visisted(const location& previous_location) {
+        visited_states_[state_index(pos_)] = true;
+        // the first visit of a cell, regardless of direction, adds it to the unique locations
+        if(const std::size_t cell = cell_index(pos_); !visited_cells_[cell]) {
+            visited_cells_[cell] = true;
+            unique_locations_.push_back(pos_);
+            entry_locations_.push_back(previous_location);
         }
     }
 
-    [[nodiscard]] bool is_in_bounds(const location& l) {
-        return (l.m > -1) && (l.m < height_) && (l.n > -1) && (l.n < width_);
-    }
-
     [[nodiscard]] field get_next_field() {
         const location l {
             .m = pos_.m + location::direction_offset_[static_cast<uint32_t>(pos_.dir)][0],
             .n = pos_.n + location::direction_offset_[static_cast<uint32_t>(pos_.dir)][1],
             .dir = pos_.dir};
-        if(is_in_bounds(l))
-            return map_[l.m][l.n];
-        return field::invalid;
+        // the guard never leaves the map, so the next field is at most the invalid border
+        if(extra_obstacle_ && extra_obstacle_->m == l.m && extra_obstacle_->n == l.n)
+            return field::obstacle;
+        return map_.at(l.m, l.n);
     }
 
     states state_ {states::standby};
     bool loop_detected_ = false;
-    const mat& map_;
+    const grid& map_;
     const int32_t width_;
     const int32_t height_;
     location pos_;
-    std::vector<std::pair<location, uint32_t>> visited_locations_;
+    const std::optional<location> extra_obstacle_;
+    std::vector<bool> visited_states_;         //!< one bit per (row, col, direction)
+    std::vector<bool> visited_cells_;          //!< one bit per (row, col)
+    std::vector<location> unique_locations_;   //!< cells in order of their first visit
+    std::vector<location> entry_locations_;    //!< guard state right before each first visit
 };
 
-std::optional<location> get_guard_position(const mat& map) {
-    const std::size_t rows = map.size();
-    const std::size_t cols = map[0].size();
+std::optional<location> get_guard_position(const grid& map) {
+    const int32_t rows = map.height();
+    const int32_t cols = map.width();
     for(int32_t m = 0U; m < rows; ++m) {
         for(int32_t n = 0U; n < cols; ++n) {
-            if(map[m][n] == field::guard)
+            if(map.at(m, n) == field::guard)
                 return location {.m = m, .n = n, .dir = location::direction::up};
         }
     }
     return std::nullopt;
 }
 
-int64_t stage_1(const mat& map) {
-    std::optional<location> guard_position = get_guard_position(map);
-    if(!guard_position) {
-        std::cout << "No valid guard position found";
-        return -1;
+/**
+ * @brief For every cell and direction, holds the coordinate along the direction of travel at
+ * which the guard stops in front of the next obstacle, or -1 if the guard walks off the map.
+ *
+ * Moving up or down only changes the row, moving left or right only the column, so a single
+ * coordinate per entry is enough.
+ */
+class jump_table {
+  public:
+    static constexpr int32_t exits_map = -1;
+
+    explicit jump_table(const grid& map) :
+        width_(map.width()),
+        height_(map.height()),
+        targets_(static_cast<std::size_t>(width_) * height_ * 4U, exits_map) {
+        for(int32_t n = 0; n < width_; ++n) {
+            int32_t last_obstacle = exits_map;
+            for(int32_t m = 0; m < height_; ++m) {
+                if(map.at(m, n) == field::obstacle)
+                    last_obstacle = m;
+                else if(last_obstacle != exits_map)
+                    at(m, n, location::direction::up) = last_obstacle + 1;
+            }
+            last_obstacle = exits_map;
+            for(int32_t m = height_ - 1; m >= 0; --m) {
+                if(map.at(m, n) == field::obstacle)
+                    last_obstacle = m;
+                else if(last_obstacle != exits_map)
+                    at(m, n, location::direction::down) = last_obstacle - 1;
+            }
+        }
+        for(int32_t m = 0; m < height_; ++m) {
+            int32_t last_obstacle = exits_map;
+            for(int32_t n = 0; n < width_; ++n) {
+                if(map.at(m, n) == field::obstacle)
+                    last_obstacle = n;
+                else if(last_obstacle != exits_map)
+                    at(m, n, location::direction::left) = last_obstacle + 1;
+            }
+            last_obstacle = exits_map;
+            for(int32_t n = width_ - 1; n >= 0; --n) {
+                if(map.at(m, n) == field::obstacle)
+                    last_obstacle = n;
+                else if(last_obstacle != exits_map)
+                    at(m, n, location::direction::right) = last_obstacle - 1;
+            }
+        }
     }
-    guard g {map, *guard_position};
 
-    while(g.move()) {
+    /**
+     * @brief Position in front of the next obstacle in the direction faced, taking an additional
+     * obstacle into account which only patches entries in its own row and column.
+     *
+     * @return std::nullopt if the guard leaves the map
+     */
+    [[nodiscard]] std::optional<location> jump(const location& l,
+                                               const location& extra_obstacle) const {
+        int32_t target = targets_[index(l.m, l.n, l.dir)];
+        switch(l.dir) {
+        case location::direction::up:
+            if(extra_obstacle.n == l.n && extra_obstacle.m < l.m
+               && (target == exits_map || extra_obstacle.m >= target))
+                target = extra_obstacle.m + 1;
+            break;
+        case location::direction::down:
+            if(extra_obstacle.n == l.n && extra_obstacle.m > l.m
+               && (target == exits_map || extra_obstacle.m <= target))
+                target = extra_obstacle.m - 1;
+            break;
+        case location::direction::left:
+            if(extra_obstacle.m == l.m && extra_obstacle.n < l.n
+               && (target == exits_map || extra_obstacle.n >= target))
+                target = extra_obstacle.n + 1;
+            break;
+        case location::direction::right:
+            if(extra_obstacle.m == l.m && extra_obstacle.n > l.n
+               && (target == exits_map || extra_obstacle.n <= target))
+                target = extra_obstacle.n - 1;
+            break;
+        }
+        if(target == exits_map)
+            return std::nullopt;
+        if(l.dir == location::direction::up || l.dir == location::direction::down)
+            return location {.m = target, .n = l.n, .dir = l.dir};
+        return location {.m = l.m, .n = target, .dir = l.dir};
     }
-    return g.num_locations_visited();
-}
 
-int64_t stage_2(const mat& map) {
-    std::optional<location> guard_position = get_guard_position(map);
-    if(!guard_position) {
-        std::cout << "No valid guard position found";
-        return -1;
+    [[nodiscard]] int32_t width() const {
+        return width_;
     }
-    guard g {map, *guard_position};
 
-    while(g.move()) {
+    [[nodiscard]] int32_t height() const {
+        return height_;
     }
 
-    const std::vector<location> visited_locations = g.visited_locations();
+  private:
+    [[nodiscard]] std::size_t index(const int32_t m,
+                                    const int32_t n,
+                                    const location::direction dir) const {
+        return (static_cast<std::size_t>(m) * width_ + n) * 4U + static_cast<uint32_t>(dir);
+    }
 
-    mat mutable_map = map;
-    uint64_t detected_loops {};
-    const auto num_locations = g.num_locations_visited();
-    uint64_t counter {};
-    std::cout << "\n";
-    for(const auto& visited_location: visited_locations) {
-        std::cout << std::format("{}/{}, checking location [{:4} {:4}]\r",
-                                 counter,
-                                 num_locations,
-                                 visited_location.m,
-                                 visited_location.n);
-        mutable_map[visited_location.m][visited_location.n] = field::obstacle;
-        guard gd {mutable_map, *guard_position};
-        while(gd.move()) {
+    int32_t& at(const int32_t m, const int32_t n, const location::direction dir) {
+        return targets_[index(m, n, dir)];
+    }
+
+    const int32_t width_;
+    const int32_t height_;
+    std::vector<int32_t> targets_;
+};
+
+/**
+ * @brief Walks the guard from turn to turn using a jump_table, so loop detection only has to
+ * remember the states in which the guard turned.
+ */
+class jump_guard {
+  public:
+    explicit jump_guard(const jump_table& table) : table_(table) {
+    }
+
+    [[nodiscard]] bool is_loop(const location& start_position, const location& extra_obstacle) {
+        // allocated on first use, so idle thread local guards never pay for it
+        if(turn_states_.empty())
+            turn_states_.resize(static_cast<std::size_t>(table_.width()) * table_.height() * 4U,
+                                false);
+        bool loop_detected = false;
+        location pos = start_position;
+        while(const std::optional<location> next = table_.jump(pos, extra_obstacle)) {
+            pos = *next;
+            const std::size_t state =
+                (static_cast<std::size_t>(pos.m) * table_.width() + pos.n) * 4U
+                + static_cast<uint32_t>(pos.dir);
+            if(turn_states_[state]) {
+                loop_detected = true;
+                break;
+            }
+            turn_states_[state] = true;
+            touched_states_.push_back(state);
+            pos.dir = turn_right(pos.dir);
+        }
+        // only reset what this walk has set instead of clearing the whole bitset
+        for(const std::size_t state: touched_states_)
+            turn_states_[state] = false;
+        touched_states_.clear();
+        return loop_detected;
+    }
+
+  private:
+    [[nodiscard]] static location::direction turn_right(const location::direction dir) {
+        return static_cast<location::direction>((static_cast<uint32_t>(dir) + 1U) % 4U);
+    }
+
+    const jump_table& table_;
+    std::vector<bool> turn_states_;   //!< one bit per (row, col, direction) the guard turned at
+    std::vector<std::size_t> touched_states_;
+};
+
+/**
+ * @brief Steps the guard cell by cell on nothing but the 2-bit grid and detects loops with
+ * Brent's algorithm, so checking a candidate needs O(1) memory on top of the shared map.
+ */
+class brent_guard {
+  public:
+    explicit brent_guard(const grid& map) : map_(map) {
+    }
+
+    [[nodiscard]] bool is_loop(const location& start_position,
+                               const std::optional<location>& extra_obstacle) const {
+        return cycle_length(start_position, extra_obstacle).has_value();
+    }
+
+    /**
+     * @brief Walks the unmodified map like guard does and collects the cells in order of their
+     * first visit together with the state right before each first visit, remembering one bit
+     * per cell instead of guard's five. If the guard loops on the unmodified map, the walk ends
+     * after the last state before the first repetition, just like guard's.
+     */
+    void first_visits(const location& start_position,
+                      std::vector<location>& visited_locations,
+                      std::vector<location>& entry_locations) const {
+        uint64_t states = std::numeric_limits<uint64_t>::max();
+        if(const std::optional<uint64_t> lambda = cycle_length(start_position, std::nullopt)) {
+            // the first repeated state lies mu steps in, so mu + lambda states are distinct
+            location tortoise = start_position;
+            location hare = start_position;
+            for(uint64_t step = 0U; step < *lambda; ++step)
+                hare = *next_state(hare, std::nullopt);
+            uint64_t mu {};
+            for(; tortoise != hare; ++mu) {
+                tortoise = *next_state(tortoise, std::nullopt);
+                hare = *next_state(hare, std::nullopt);
+            }
+            states = mu + *lambda;
+        }
+
+        std::vector<bool> visited_cells(static_cast<std::size_t>(map_.width()) * map_.height(),
+                                        false);
+        location previous = start_position;
+        std::optional<location> pos = start_position;
+        for(uint64_t state = 0U; pos && state < states; ++state) {
+            if(const std::size_t cell = static_cast<std::size_t>(pos->m) * map_.width() + pos->n;
+               !visited_cells[cell]) {
+                visited_cells[cell] = true;
+                visited_locations.push_back(*pos);
+                entry_locations.push_back(previous);
+            }
+            previous = *pos;
+            pos = next_state(*pos, std::nullopt);
         }
-        if(gd.was_loop_detected())
-            ++detected_loops;
-        mutable_map[visited_location.m][visited_location.n] = field::empty;
-        ++counter;
     }
+
+  private:
+    /**
+     * @brief Brent's algorithm on the sequence of guard states.
+     *
+     * @return length of the loop the guard ends up in, std::nullopt if it leaves the map
+     */
+    [[nodiscard]] std::optional<uint64_t>
+        cycle_length(const location& start_position,
+                     const std::optional<location>& extra_obstacle) const {
+        location tortoise = start_position;
+        std::optional<location> hare = next_state(start_position, extra_obstacle);
+        uint64_t power = 1U;
+        uint64_t length = 1U;
+        while(hare) {
+            if(*hare == tortoise)
+                return length;
+            if(power == length) {
+                tortoise = *hare;
+                power *= 2U;
+                length = 0U;
+            }
+            hare = next_state(*hare, extra_obstacle);
+            ++length;
+        }
+        return std::nullopt;
+    }
+
+    /**
+     * @return the state after turning right in front of an obstacle or moving one cell ahead,
+     * std::nullopt if the guard leaves the map
+     */
+    [[nodiscard]] std::optional<location>
+        next_state(const location& l, const std::optional<location>& extra_obstacle) const {
+        const location ahead {
+            .m = l.m + location::direction_offset_[static_cast<uint32_t>(l.dir)][0],
+            .n = l.n + location::direction_offset_[static_cast<uint32_t>(l.dir)][1],
+            .dir = l.dir};
+        const field next_field =
+            (extra_obstacle && extra_obstacle->m == ahead.m && extra_obstacle->n == ahead.n)
+                ? field::obstacle
+                : map_.at(ahead.m, ahead.n);
+        if(next_field == field::invalid)
+            return std::nullopt;
+        if(next_field == field::obstacle) {
+            return location {.m = l.m,
+                             .n = l.n,
+                             .dir = static_cast<location::direction>(
+                                 (static_cast<uint32_t>(l.dir) + 1U) % 4U)};
+        }
+        return ahead;
+    }
+
+    const grid& map_;
+};
+
+enum class simulation_mode { step, jump };
+enum class loop_detection { visited_set, brent };
+
+/**
+ * @brief The guard's walk on the unmodified map, shared by both stages.
+ */
+struct guard_walk {
+    std::vector<location> visited_locations; //!< cells in order of their first visit
+    std::vector<location> entry_locations;   //!< state right before each first visit
+};
+
+/**
+ * @brief Walks the map once with the guard matching the loop detection, so brent mode never
+ * keeps guard's five bits per cell.
+ */
+guard_walk
+    walk_map(const grid& map, const location& start_position, const loop_detection detection) {
+    guard_walk walk;
+    if(detection == loop_detection::brent) {
+        brent_guard {map}.first_visits(start_position, walk.visited_locations,
+                                       walk.entry_locations);
+    } else {
+        guard g {map, start_position};
+        while(g.move()) {
+        }
+        walk.visited_locations = g.visited_locations();
+        walk.entry_locations = g.entry_locations();
+    }
+    return walk;
+}
+
+int64_t stage_1(const guard_walk& walk) {
+    return walk.visited_locations.size();
+}
+
+/**
+ * @param detection loop_detection::brent is only supported with simulation_mode::step
+ */
+int64_t stage_2(const grid& map,
+                const guard_walk& walk,
+                const simulation_mode mode,
+                const loop_detection detection) {
+    // an obstacle on a cell only changes the walk from the cell's first visit on, so each check
+    // resumes from the state in front of the candidate instead of replaying the shared prefix
+    const std::vector<location>& visited_locations = walk.visited_locations;
+    const std::vector<location>& entry_locations = walk.entry_locations;
+    const brent_guard brent {map};
+
+    // the jump table costs 16 bytes per cell, so it is only built for the mode using it
+    std::optional<jump_table> table;
+    if(mode == simulation_mode::jump)
+        table.emplace(map);
+    // every worker thread keeps its own turn state scratch space
+    tbb::enumerable_thread_specific<jump_guard> jump_guards {[&]() {
+        return jump_guard {*table};
+    }};
+    const std::size_t num_locations = visited_locations.size();
+    // report progress roughly every percent instead of for every candidate
+    const std::size_t progress_step = std::max<std::size_t>(num_locations / 100U, 1U);
+    std::atomic<std::size_t> counter {};
+    std::cout << "\n";
+
+    const uint64_t detected_loops = tbb::parallel_reduce(
+        tbb::blocked_range<std::size_t> {0U, num_locations},
+        uint64_t {},
+        [&](const tbb::blocked_range<std::size_t>& range, uint64_t loops) {
+            for(std::size_t i = range.begin(); i != range.end(); ++i) {
+                const location& candidate = visited_locations[i];
+                const location& resume_position = entry_locations[i];
+                if(detection == loop_detection::brent) {
+                    if(brent.is_loop(resume_position, candidate))
+                        ++loops;
+                } else if(mode == simulation_mode::jump) {
+                    if(jump_guards.local().is_loop(resume_position, candidate))
+                        ++loops;
+                } else {
+                    guard gd {map, resume_position, candidate};
+                    while(gd.move()) {
+                    }
+                    if(gd.was_loop_detected())
+                        ++loops;
+                }
+            }
+            const std::size_t done = counter.fetch_add(range.size()) + range.size();
+            if(done / progress_step != (done - range.size()) / progress_step)
+                std::cout << std::format("{}/{} locations checked\r", done, num_locations);
+            return loops;
+        },
+        std::plus<uint64_t> {});
     std::cout << "\n";
     return detected_loops;
 }
@@ -310,7 +693,31 @@ int main(int argc, char** argv) {
         return 1;
     }
 
-    const mat map = get_map(argv[1]);
-    std::cout << "STAGE 1: " << stage_1(map) << " locations visited\n";
-    std::cout << "STAGE 2: " << stage_2(map) << " loops detected\n";
+    // the jump table simulation with a visited set is the default, "step" selects the cell by
+    // cell guard and "brent" the cell by cell guard with constant memory loop detection
+    simulation_mode mode = simulation_mode::jump;
+    loop_detection detection = loop_detection::visited_set;
+    for(int arg_i = 2; arg_i < argc; ++arg_i) {
+        const std::string arg {argv[arg_i]};
+        if(arg == "step") {
+            mode = simulation_mode::step;
+        } else if(arg == "brent") {
+            detection = loop_detection::brent;
+        } else {
+            std::cout << "Unknown argument " << arg << "\n";
+            return 1;
+        }
+    }
+    if(detection == loop_detection::brent)
+        mode = simulation_mode::step;
+
+    const grid map = get_map(argv[1]);
+    std::optional<location> guard_position = get_guard_position(map);
+    if(!guard_position) {
+        std::cout << "No valid guard position found";
+        return 1;
+    }
+    const guard_walk walk = walk_map(map, *guard_position, detection);
+    std::cout << "STAGE 1: " << stage_1(walk) << " locations visited\n";
+    std::cout << "STAGE 2: " << stage_2(map, walk, mode, detection) << " loops detected\n";
 }
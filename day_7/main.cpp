@@ -1,18 +1,25 @@
 #include <algorithm>
 #include <array>
+#include <bit>
 #include <chrono>
-#include <cmath>
 #include <cstdint>
 #include <filesystem>
 #include <format>
 #include <fstream>
+#include <functional>
 #include <iostream>
+#include <limits>
+#include <numeric>
+#include <optional>
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <utility>
 #include <vector>
 
 #include <sys/types.h>
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_reduce.h>
 
 std::vector<std::vector<uint64_t>> get_input(const std::filesystem::path& path) {
     const std::filesystem::path ws_path = std::filesystem::canonical(path);
@@ -39,220 +46,436 @@ std::vector<std::vector<uint64_t>> get_input(const std::filesystem::path& path)
     return input;
 }
 
-class stage_2_solver {
-  public:
-    stage_2_solver() = default;
-
-    uint64_t solve(const std::vector<std::vector<uint64_t>>& input) {
-        const uint32_t max_permutation_sz = find_max_permutation_sz(input);
-        std::vector<std::vector<std::vector<opcode>>> opcode_permutations;
-        for(uint32_t perm_i = 1U; perm_i <= max_permutation_sz; ++perm_i)
-            opcode_permutations.emplace_back(calculate_opcode_permutations(perm_i));
-
-        uint64_t total_calibration_sum = {};
-
-        for(const auto& line: input) {
-            const uint64_t expected_result = line[0U];
-            // -2 U because the result is stored as the first element of the vector and we only need
-            // n - 1 inputs when we get n numbers as input
-            const std::size_t permutation_length = line.size() - 2U;
-            // -1 because we're zero based when indexing
-            const std::vector<std::vector<opcode>>& valid_opcode_permutations =
-                opcode_permutations[permutation_length - 1U];
-
-            for(const auto& opcode_permutation: valid_opcode_permutations) {
-                uint64_t computation_result = line[1U];
-                for(std::size_t opcode_i = 0U; opcode_i < opcode_permutation.size(); ++opcode_i) {
-                    computation_result = compute(
-                        computation_result, line[opcode_i + 2U], opcode_permutation[opcode_i]);
-                }
-                if(computation_result == expected_result) {
-                    total_calibration_sum += computation_result;
-                    break;
-                }
+/**
+ * @brief Sums the expected results of all lines that is_solvable accepts, solving the lines in
+ * parallel on TBB's work stealing scheduler.
+ *
+ * The cost of a line grows with operators^length, so lines are handed out longest first and
+ * the short ones fill up the gaps at the end.
+ */
+template<typename predicate_t>
+uint64_t parallel_calibration_sum(const std::vector<std::vector<uint64_t>>& input,
+                                  predicate_t&& is_solvable) {
+    std::vector<std::size_t> order(input.size());
+    std::iota(order.begin(), order.end(), 0U);
+    std::stable_sort(order.begin(), order.end(), [&](const std::size_t lhs, const std::size_t rhs) {
+        return input[lhs].size() > input[rhs].size();
+    });
+
+    return tbb::parallel_reduce(
+        tbb::blocked_range<std::size_t> {0U, order.size(), 1U},
+        uint64_t {},
+        [&](const tbb::blocked_range<std::size_t>& range, uint64_t sum) {
+            for(std::size_t i = range.begin(); i != range.end(); ++i) {
+                const std::vector<uint64_t>& line = input[order[i]];
+                if(line.size() >= 2U && is_solvable(line))
+                    sum += line[0U];
             }
-        }
-        return total_calibration_sum;
+            return sum;
+        },
+        std::plus<uint64_t> {});
+}
+
+// 10^0 to 10^19, every power of ten that fits into an uint64_t
+constexpr std::array<uint64_t, 20U> powers_of_ten = []() {
+    std::array<uint64_t, 20U> powers {};
+    uint64_t power {1U};
+    for(uint64_t& p: powers) {
+        p = power;
+        power *= 10U;
     }
+    return powers;
+}();
 
-  private:
-    enum class opcode { add, mul, cat };
-    static constexpr std::array<opcode, 3U> opcode_set {{opcode::add, opcode::mul, opcode::cat}};
-
-    std::string opcode_to_str(const opcode op) {
-        if(opcode::cat == op)
-            return "cat";
-        if(opcode::add == op)
-            return "add";
-        return "mul";
+/**
+ * @brief Smallest power of ten greater than x, i.e. the factor x has to be shifted by when
+ * appending it, or 0 if that doesn't fit into an uint64_t. The digits are counted without
+ * branches: bit_width * log10(2) estimates them, one comparison corrects the estimate.
+ */
+constexpr uint64_t decimal_shift(const uint64_t x) {
+    // 1233 / 4096 ~ log10(2)
+    std::size_t digits = (std::bit_width(x | 1U) * 1233U) >> 12U;
+    digits += static_cast<std::size_t>((x | 1U) >= powers_of_ten[digits]);
+    return digits < powers_of_ten.size() ? powers_of_ten[digits] : 0U;
+}
+
+/**
+ * Operators provide apply(x, y) for the left to right evaluation, std::nullopt if the result
+ * overflows, and invert(target, y), the x for which apply(x, y) == target, or std::nullopt if
+ * there is none. For positive operands every operator is non-decreasing in x and y.
+ *
+ * apply_unchecked(x, y) is apply without the overflow check, for callers that made sure
+ * x * growth(y) + y fits into an uint64_t, which bounds every operator's result.
+ */
+struct add_op {
+    static constexpr std::optional<uint64_t> apply(const uint64_t x, const uint64_t y) {
+        uint64_t result {};
+        if(__builtin_add_overflow(x, y, &result))
+            return std::nullopt;
+        return result;
     }
 
-    // https://www.geeksforgeeks.org/print-all-the-permutation-of-length-l-using-the-elements-of-an-array-iterative/
-    std::vector<std::vector<opcode>> calculate_opcode_permutations(const std::size_t sz) {
-        const uint64_t possible_permutations = std::pow<uint64_t>(opcode_set.size(), sz);
-        std::vector<std::vector<opcode>> permutations;
-
-        for(uint64_t perm_i = 0U; perm_i < possible_permutations; ++perm_i) {
-            std::vector<opcode> permutation;
-            uint64_t n = perm_i;
-            for(std::size_t opcode_i = 0U; opcode_i < sz; ++opcode_i) {
-                const opcode op = opcode_set[n % opcode_set.size()];
-                n /= opcode_set.size();
-                permutation.emplace_back(op);
-            }
-            permutations.emplace_back(permutation);
-        }
-        return permutations;
+    static constexpr uint64_t apply_unchecked(const uint64_t x, const uint64_t y) {
+        return x + y;
     }
 
-    uint64_t find_max_permutation_sz(const std::vector<std::vector<uint64_t>>& input) {
-        std::vector<std::size_t> v;
-        v.reserve(input.size());
-        // substract 1 from the length of a line because the result of the operations
-        // is stored as the first element in the vector
-        std::for_each(input.cbegin(), input.cend(), [&](const std::vector<uint64_t>& i) {
-            v.push_back(i.size() - 1U);
-        });
-        if(const auto it = std::max_element(v.cbegin(), v.cend()); it != v.cend())
-            return *it - 1;    // -1 because for n input values we only need n - 1 opcodes
-        return 0U;
+    static constexpr uint64_t growth(const uint64_t /*y*/) {
+        return 1U;
     }
 
-    uint64_t digit_count(uint64_t x) {
-        uint64_t digits {1U};
-        while(x /= 10)
-            ++digits;
-        return digits;
+    static constexpr std::optional<uint64_t> invert(const uint64_t target, const uint64_t y) {
+        if(target < y)
+            return std::nullopt;
+        return target - y;
     }
+};
 
-    uint64_t compute(const uint64_t x, const uint64_t y, const opcode op) {
-        uint64_t result = {};
-        switch(op) {
-        case opcode::add:
-            result = x + y;
-            break;
-        case opcode::mul:
-            result = x * y;
-            break;
-        case opcode::cat:
-            result = x * std::pow<uint64_t>(10U, digit_count(y)) + y;
-        }
+struct mul_op {
+    static constexpr std::optional<uint64_t> apply(const uint64_t x, const uint64_t y) {
+        uint64_t result {};
+        if(__builtin_mul_overflow(x, y, &result))
+            return std::nullopt;
         return result;
-    };
+    }
+
+    static constexpr uint64_t apply_unchecked(const uint64_t x, const uint64_t y) {
+        return x * y;
+    }
+
+    static constexpr uint64_t growth(const uint64_t y) {
+        return y;
+    }
+
+    // operands are positive, so a factor of zero is never inverted
+    static constexpr std::optional<uint64_t> invert(const uint64_t target, const uint64_t y) {
+        if(y == 0U || target % y != 0U)
+            return std::nullopt;
+        return target / y;
+    }
 };
 
-class stage_1_solver {
+struct cat_op {
+    static constexpr std::optional<uint64_t> apply(const uint64_t x, const uint64_t y) {
+        const uint64_t shift = decimal_shift(y);
+        uint64_t result {};
+        if(shift == 0U || __builtin_mul_overflow(x, shift, &result)
+           || __builtin_add_overflow(result, y, &result))
+            return std::nullopt;
+        return result;
+    }
+
+    static constexpr uint64_t apply_unchecked(const uint64_t x, const uint64_t y) {
+        return x * decimal_shift(y) + y;
+    }
+
+    // an operand too long to shift by can't be bounded, which forces the checked path
+    static constexpr uint64_t growth(const uint64_t y) {
+        const uint64_t shift = decimal_shift(y);
+        return shift == 0U ? std::numeric_limits<uint64_t>::max() : shift;
+    }
+
+    static constexpr std::optional<uint64_t> invert(const uint64_t target, const uint64_t y) {
+        const uint64_t shift = decimal_shift(y);
+        if(target < y || shift == 0U || (target - y) % shift != 0U)
+            return std::nullopt;
+        return (target - y) / shift;
+    }
+};
+
+/**
+ * @brief Solver for a compile time set of operators, every dispatch over the operators is
+ * expanded from the parameter pack and inlined.
+ */
+template<typename... operators>
+class solver {
   public:
-    stage_1_solver() = default;
-
-    uint64_t solve(const std::vector<std::vector<uint64_t>>& input) {
-        const uint32_t max_permutation_sz = find_max_permutation_sz(input);
-        std::vector<std::vector<std::vector<opcode>>> opcode_permutations;
-        // for each input length, pre calculate the possible opcode permutations
-        for(uint32_t perm_i = 1U; perm_i <= max_permutation_sz; ++perm_i)
-            opcode_permutations.emplace_back(calculate_opcode_permutations(perm_i));
-
-        uint64_t total_calibration_sum = {};
-
-        for(const auto& line: input) {
-            const uint64_t expected_result = line[0U];
-            // -2 U because the result is stored as the first element of the vector and we only
-            // need n - 1 inputs when we get n numbers as input
-            const std::size_t permutation_length = line.size() - 2U;
-            // -1 because we're zero based when indexing
-            const std::vector<std::vector<opcode>>& valid_opcode_permutations =
-                opcode_permutations[permutation_length - 1U];
-
-            for(const auto& opcode_permutation: valid_opcode_permutations) {
-                uint64_t computation_result = line[1U];
-                for(std::size_t opcode_i = 0U; opcode_i < opcode_permutation.size(); ++opcode_i) {
-                    computation_result = compute(
-                        computation_result, line[opcode_i + 2U], opcode_permutation[opcode_i]);
-                }
-                if(computation_result == expected_result) {
-                    total_calibration_sum += computation_result;
+    solver() = default;
+
+    /**
+     * @brief Works right to left from the expected result, undoing one operation per operand and
+     * pruning every branch that can't be inverted.
+     */
+    uint64_t solve(const std::vector<std::vector<uint64_t>>& input) const {
+        return parallel_calibration_sum(input, [&](const std::vector<uint64_t>& line) {
+            return is_reachable(line[0U], line, line.size() - 1U);
+        });
+    }
+
+    uint64_t solve_exhaustive(const std::vector<std::vector<uint64_t>>& input) const {
+        return parallel_calibration_sum(input, [&](const std::vector<uint64_t>& line) {
+            return has_matching_permutation(line);
+        });
+    }
+
+    /**
+     * @brief Evaluates all opcode permutations level by level, every reachable partial result is
+     * one lane and each operator is applied to all lanes in a flat loop without branches.
+     */
+    uint64_t solve_lanes(const std::vector<std::vector<uint64_t>>& input) const {
+        return parallel_calibration_sum(input, [&](const std::vector<uint64_t>& line) {
+            return has_matching_permutation_lanes(line);
+        });
+    }
+
+    /**
+     * @brief Enumerates every value the left half of the operands can produce, then works the
+     * right half backwards from the expected result and looks the remaining values up. This
+     * costs roughly k^(n/2) instead of k^n for n operands and k operators.
+     */
+    uint64_t solve_meet_in_the_middle(const std::vector<std::vector<uint64_t>>& input) const {
+        return parallel_calibration_sum(input, [&](const std::vector<uint64_t>& line) {
+            // the left half holds line[1U] to line[split]
+            const std::size_t split = line.size() / 2U;
+            const std::vector<uint64_t> left_values = reachable_values(line, split);
+            return meets_left_half(line[0U], line, line.size() - 1U, split, left_values);
+        });
+    }
+
+  private:
+    static constexpr std::size_t operator_count = sizeof...(operators);
+    //! 2 MiB of partial results per lane buffer
+    static constexpr std::size_t max_evaluation_lanes = 1U << 18U;
+
+    /**
+     * @brief Enumerates the opcode permutations of a line lazily, like an odometer whose last
+     * opcode changes fastest. After each step only the partial results from the first changed
+     * opcode on are recomputed, so memory stays O(n) for a line with n operands.
+     *
+     * As no operator decreases the running result, every permutation sharing a prefix whose
+     * result already exceeds the expected one, or overflows, is skipped at once.
+     */
+    bool has_matching_permutation(const std::vector<uint64_t>& line) const {
+        // -2 U because the result is stored as the first element of the vector and we only need
+        // n - 1 opcodes when we get n numbers as input
+        const std::size_t permutation_length = line.size() - 2U;
+        std::vector<std::size_t> opcode_indices(permutation_length, 0U);
+        // partial_results[i] holds the result after applying the first i opcodes
+        std::vector<uint64_t> partial_results(permutation_length + 1U);
+        partial_results[0U] = line[1U];
+        std::size_t first_changed {};
+        while(true) {
+            // one past the last opcode that has to change for the next permutation
+            std::size_t digit = permutation_length;
+            bool exceeded = false;
+            for(std::size_t opcode_i = first_changed; opcode_i < permutation_length; ++opcode_i) {
+                const std::optional<uint64_t> result = compute(
+                    partial_results[opcode_i], line[opcode_i + 2U], opcode_indices[opcode_i]);
+                if(!result || *result > line[0U]) {
+                    exceeded = true;
+                    digit = opcode_i + 1U;
                     break;
                 }
+                partial_results[opcode_i + 1U] = *result;
             }
+            if(!exceeded && partial_results[permutation_length] == line[0U])
+                return true;
+
+            // skip all permutations that share the pruned prefix
+            std::fill(opcode_indices.begin() + digit, opcode_indices.end(), 0U);
+            while(digit > 0U && ++opcode_indices[digit - 1U] == operator_count) {
+                opcode_indices[digit - 1U] = 0U;
+                --digit;
+            }
+            if(digit == 0U)
+                return false;
+            first_changed = digit - 1U;
         }
-        return total_calibration_sum;
     }
 
-  private:
-    enum class opcode { add, mul };
-    static constexpr std::array<opcode, 2U> opcode_set {{opcode::add, opcode::mul}};
-
-    std::string opcode_to_str(opcode op) {
-        if(op == opcode::add)
-            return "add";
-        else
-            return "mul";
-    }
     /**
-     * @brief
+     * @brief Keeps the partial results of all opcode prefixes side by side and extends them by
+     * one operand at a time. Every operator writes its results for all lanes into its own
+     * contiguous block, which the compiler turns into vector code. Lanes exceeding the expected
+     * result are compacted away afterwards, the same pruning the odometer does. Lines needing
+     * more than max_evaluation_lanes lanes are left to the odometer.
      *
-     * @param sz length of the array holding the opcodes, e.g. {add, mul, mul} -> 3U
-     * @return
+     * The overflow checks are hoisted out of the lanes: as long as no operator can overflow
+     * for a partial result up to the expected result, apply_unchecked is exact. Lines where
+     * that doesn't hold fall back to the pruned odometer.
      */
-    std::vector<std::vector<opcode>> calculate_opcode_permutations(const std::size_t sz) {
-        const auto possible_permutations = std::pow<uint64_t>(2U, sz);
-        std::vector<std::vector<opcode>> permutations;
-
-        for(std::size_t perm_i = 0U; perm_i < possible_permutations; ++perm_i) {
-            std::vector<opcode> permutation;
-            for(std::size_t bit = 0U; bit < sz; ++bit) {
-                // opcodes are binary, so each permutation number perm_i can be interpreted
-                // as a permutation of opcodes, e.g. 3 => 011 => add, mul, mul
-                permutation.push_back(opcode_set[(perm_i >> bit) & 0x1]);
+    bool has_matching_permutation_lanes(const std::vector<uint64_t>& line) const {
+        const uint64_t expected_result = line[0U];
+        // the overflow bound below only holds for lanes up to the expected result
+        if(line[1U] > expected_result)
+            return false;
+        std::vector<uint64_t> values {line[1U]};
+        std::vector<uint64_t> next_values;
+        for(std::size_t operand_i = 2U; operand_i < line.size(); ++operand_i) {
+            const uint64_t operand = line[operand_i];
+            const uint64_t growth = std::max({operators::growth(operand)...});
+            uint64_t bound {};
+            if(__builtin_mul_overflow(expected_result, growth, &bound)
+               || __builtin_add_overflow(bound, operand, &bound))
+                return has_matching_permutation(line);
+
+            const std::size_t values_sz = values.size();
+            // the lanes grow by up to operator_count per operand, past the cap the memory is
+            // bounded by falling back to the odometer
+            if(values_sz * operator_count > max_evaluation_lanes)
+                return has_matching_permutation(line);
+            const uint64_t* const lanes = values.data();
+            // the last operand only has to be matched, not stored
+            if(operand_i + 1U == line.size()) {
+                const auto matches = [&]<typename op>() {
+                    uint64_t matched {};
+                    for(std::size_t lane = 0U; lane < values_sz; ++lane) {
+                        matched |= static_cast<uint64_t>(
+                            op::apply_unchecked(lanes[lane], operand) == expected_result);
+                    }
+                    return matched != 0U;
+                };
+                return (matches.template operator()<operators>() || ...);
             }
-            permutations.emplace_back(permutation);
-        }
 
-        return permutations;
+            next_values.resize(values_sz * operator_count);
+            uint64_t* next_lanes = next_values.data();
+            const auto expand = [&]<typename op>() {
+                for(std::size_t lane = 0U; lane < values_sz; ++lane)
+                    next_lanes[lane] = op::apply_unchecked(lanes[lane], operand);
+                next_lanes += values_sz;
+            };
+            (expand.template operator()<operators>(), ...);
+
+            std::size_t kept {};
+            for(const uint64_t value: next_values) {
+                next_values[kept] = value;
+                kept += static_cast<std::size_t>(value <= expected_result);
+            }
+            if(kept == 0U)
+                return false;
+            next_values.resize(kept);
+            std::swap(values, next_values);
+        }
+        return values.front() == expected_result;
     }
 
-    uint64_t find_max_permutation_sz(const std::vector<std::vector<uint64_t>>& input) {
-        std::vector<std::size_t> v;
-        v.reserve(input.size());
-        // substract 1 from the length of a line because the result of the operations
-        // is stored as the first element in the vector
-        std::for_each(input.cbegin(), input.cend(), [&](const std::vector<uint64_t>& i) {
-            v.push_back(i.size() - 1U);
-        });
-        if(const auto it = std::max_element(v.cbegin(), v.cend()); it != v.cend())
-            return *it - 1;    // -1 because for n input values we only need n - 1 opcodes
-        return 0U;
+    /**
+     * @brief Checks whether the operands line[1U] to line[last] can produce target.
+     */
+    bool is_reachable(const uint64_t target,
+                      const std::vector<uint64_t>& line,
+                      const std::size_t last) const {
+        const uint64_t value = line[last];
+        if(last == 1U)
+            return target == value;
+        const auto reachable_through = [&]<typename op>() {
+            const std::optional<uint64_t> previous = op::invert(target, value);
+            return previous && is_reachable(*previous, line, last - 1U);
+        };
+        return (reachable_through.template operator()<operators>() || ...);
     }
 
-    uint64_t compute(const uint64_t x, const uint64_t y, const opcode op) {
-        uint64_t result = {};
-        switch(op) {
-        case opcode::add:
-            result = x + y;
-            break;
-        case opcode::mul:
-            result = x * y;
+    /**
+     * @brief Sorted values the operands line[1U] to line[last] can produce without exceeding the
+     * expected result.
+     */
+    std::vector<uint64_t> reachable_values(const std::vector<uint64_t>& line,
+                                           const std::size_t last) const {
+        std::vector<uint64_t> values {line[1U]};
+        std::vector<uint64_t> next_values;
+        for(std::size_t operand_i = 2U; operand_i <= last; ++operand_i) {
+            next_values.clear();
+            for(const uint64_t value: values) {
+                const auto apply = [&]<typename op>() {
+                    const std::optional<uint64_t> result = op::apply(value, line[operand_i]);
+                    if(result && *result <= line[0U])
+                        next_values.push_back(*result);
+                };
+                (apply.template operator()<operators>(), ...);
+            }
+            std::sort(next_values.begin(), next_values.end());
+            next_values.erase(std::unique(next_values.begin(), next_values.end()),
+                              next_values.end());
+            std::swap(values, next_values);
         }
+        return values;
+    }
+
+    /**
+     * @brief Works the operands line[split + 1U] to line[last] backwards from target and checks
+     * whether any of the remaining values is produced by the left half.
+     */
+    bool meets_left_half(const uint64_t target,
+                         const std::vector<uint64_t>& line,
+                         const std::size_t last,
+                         const std::size_t split,
+                         const std::vector<uint64_t>& left_values) const {
+        if(last == split)
+            return std::binary_search(left_values.cbegin(), left_values.cend(), target);
+        const uint64_t value = line[last];
+        const auto meets_through = [&]<typename op>() {
+            const std::optional<uint64_t> previous = op::invert(target, value);
+            return previous && meets_left_half(*previous, line, last - 1U, split, left_values);
+        };
+        return (meets_through.template operator()<operators>() || ...);
+    }
+
+    static std::optional<uint64_t>
+        compute(const uint64_t x, const uint64_t y, const std::size_t opcode) {
+        return compute(x, y, opcode, std::index_sequence_for<operators...> {});
+    }
+
+    template<std::size_t... indices>
+    static std::optional<uint64_t> compute(const uint64_t x,
+                                           const uint64_t y,
+                                           const std::size_t opcode,
+                                           std::index_sequence<indices...>) {
+        std::optional<uint64_t> result;
+        ((opcode == indices ? (result = operators::apply(x, y), true) : false) || ...);
         return result;
     }
 };
 
+using stage_1_solver = solver<add_op, mul_op>;
+using stage_2_solver = solver<add_op, mul_op, cat_op>;
+
+enum class solve_mode { backward, exhaustive, meet_in_the_middle, lanes };
+
 int main(int argc, char** argv) {
     if(argc < 2U) {
         std::cout << "Invalid number of arguments\n";
         return 1;
     }
+    // "exhaustive" evaluates every opcode permutation, "lanes" does so several permutations at a
+    // time and "mitm" meets in the middle instead of solving backwards
+    solve_mode mode = solve_mode::backward;
+    if(argc > 2) {
+        const std::string arg {argv[2]};
+        if(arg == "exhaustive") {
+            mode = solve_mode::exhaustive;
+        } else if(arg == "mitm") {
+            mode = solve_mode::meet_in_the_middle;
+        } else if(arg == "lanes") {
+            mode = solve_mode::lanes;
+        } else {
+            std::cout << "Unknown argument " << arg << "\n";
+            return 1;
+        }
+    }
     std::vector<std::vector<uint64_t>> input = get_input(argv[1]);
+    const auto solve = [&](const auto& solver) {
+        switch(mode) {
+        case solve_mode::exhaustive:
+            return solver.solve_exhaustive(input);
+        case solve_mode::meet_in_the_middle:
+            return solver.solve_meet_in_the_middle(input);
+        case solve_mode::lanes:
+            return solver.solve_lanes(input);
+        case solve_mode::backward:
+            break;
+        }
+        return solver.solve(input);
+    };
     std::chrono::time_point<std::chrono::high_resolution_clock> start =
         std::chrono::high_resolution_clock::now();
     stage_1_solver solver_1 {};
-    const auto stage_1_result = solver_1.solve(input);
+    const auto stage_1_result = solve(solver_1);
     const auto t_stage_1 = std::chrono::duration_cast<std::chrono::microseconds>(
         std::chrono::high_resolution_clock::now() - start);
 
     start = std::chrono::high_resolution_clock::now();
     stage_2_solver solver_2 {};
-    const auto stage_2_result = solver_2.solve(input);
+    const auto stage_2_result = solve(solver_2);
     const auto t_stage_2 = std::chrono::duration_cast<std::chrono::microseconds>(
         std::chrono::high_resolution_clock::now() - start);
     std::cout << std::format(
@@ -1,23 +1,35 @@
 #include <algorithm>
+#include <array>
+#include <bit>
 #include <chrono>
-#include <cmath>
 #include <cstddef>
 #include <cstdint>
 #include <exception>
 #include <filesystem>
 #include <format>
 #include <fstream>
+#include <functional>
 #include <iostream>
+#include <limits>
+#include <numeric>
+#include <optional>
+#include <sstream>
 #include <stdexcept>
 #include <string>
+#include <unordered_set>
+#include <utility>
 #include <vector>
 
+#include <tbb/blocked_range.h>
+#include <tbb/enumerable_thread_specific.h>
+#include <tbb/parallel_for.h>
+
 using mat = std::vector<std::vector<char>>;
 namespace fs = std::filesystem;
 
 struct position {
-    int64_t m;    // row
-    int64_t n;    // col
+    int32_t m;    // row
+    int32_t n;    // col
     bool operator==(const position& rhs) const {
         return (rhs.m == m) && (rhs.n == n);
     }
@@ -33,10 +45,6 @@ struct antenna_pair {
     const char frequency;
     std::vector<position> positions;
 };
-struct antinode_pair {
-    const char frequency;
-    std::vector<position> positions;
-};
 
 // forward declaration to put utility functions at file end;
 mat get_map(const fs::path& path);
@@ -60,197 +68,657 @@ void print_positions(const std::vector<position>& pos, const fs::path& s) {
         ifs << std::format("[{}, {}]\n", p.m, p.n);
 }
 
-namespace stage_1 {
+/**
+ * @brief One bit per map cell marking antinodes, the count is a popcount over all words.
+ */
+class antinode_grid {
+  public:
+    antinode_grid(const int64_t width, const int64_t height) :
+        width_(width),
+        height_(height),
+        cells_((static_cast<std::size_t>(width * height) + 63U) / 64U, 0U) {
+    }
 
-int64_t map_width = 0;
-int64_t map_height = 0;
+    /**
+     * @return false if the position is out of bounds
+     */
+    bool mark(const position& pos) {
+        if(!::is_position_in_bounds(pos, width_, height_))
+            return false;
+        mark_unchecked(pos);
+        return true;
+    }
 
-antinode_pair calculate_antinode_positions(const antenna_pair& pair) {
-    const std::size_t antennas_sz = pair.positions.size();
-    const std::vector<position>& antennas = pair.positions;
+    void mark_unchecked(const position& pos) {
+        const std::size_t i = static_cast<std::size_t>(pos.m) * width_ + pos.n;
+        cells_[i / 64U] |= uint64_t {1U} << (i % 64U);
+    }
 
-    antinode_pair antinodes {.frequency = pair.frequency, .positions = {}};
+    void merge(const antinode_grid& other) {
+        for(std::size_t word = 0U; word < cells_.size(); ++word)
+            cells_[word] |= other.cells_[word];
+    }
 
-    for(std::size_t antenna_i = 0U; antenna_i < (antennas_sz - 1U); ++antenna_i) {
-        for(std::size_t antenna_j = antenna_i + 1U; antenna_j < antennas_sz; ++antenna_j) {
-            const int64_t distance_m = antennas.at(antenna_j).m - antennas.at(antenna_i).m;
-            const int64_t distance_n = antennas.at(antenna_j).n - antennas.at(antenna_i).n;
+    [[nodiscard]] std::size_t count() const {
+        return std::transform_reduce(
+            cells_.cbegin(), cells_.cend(), std::size_t {}, std::plus<> {}, [](const uint64_t w) {
+                return static_cast<std::size_t>(std::popcount(w));
+            });
+    }
 
-            const position antinode_1 {.m = antennas.at(antenna_i).m - distance_m,
-                                       .n = antennas.at(antenna_i).n - distance_n};
-            const position antinode_2 {.m = antennas.at(antenna_j).m + distance_m,
-                                       .n = antennas.at(antenna_j).n + distance_n};
-            if(::is_position_in_bounds(antinode_1, map_width, map_height))
-                antinodes.positions.emplace_back(antinode_1);
-            if(::is_position_in_bounds(antinode_2, map_width, map_height))
-                antinodes.positions.emplace_back(antinode_2);
-        }
+  private:
+    int64_t width_;
+    int64_t height_;
+    std::vector<uint64_t> cells_;
+};
+
+/**
+ * @brief Hash set of antinode positions for huge, sparse maps where a bit per cell doesn't fit.
+ * Together with an antenna_map read by get_antenna_list, memory scales with the number of
+ * antennas and antinodes instead of the map area.
+ */
+class antinode_set {
+  public:
+    antinode_set(const int64_t width, const int64_t height) : width_(width), height_(height) {
+    }
+
+    /**
+     * @return false if the position is out of bounds
+     */
+    bool mark(const position& pos) {
+        if(!::is_position_in_bounds(pos, width_, height_))
+            return false;
+        mark_unchecked(pos);
+        return true;
+    }
+
+    void mark_unchecked(const position& pos) {
+        cells_.insert((static_cast<uint64_t>(static_cast<uint32_t>(pos.m)) << 32U)
+                      | static_cast<uint32_t>(pos.n));
     }
+
+    void merge(const antinode_set& other) {
+        cells_.insert(other.cells_.cbegin(), other.cells_.cend());
+    }
+
+    [[nodiscard]] std::size_t count() const {
+        return cells_.size();
+    }
+
+  private:
+    int64_t width_;
+    int64_t height_;
+    std::unordered_set<uint64_t> cells_;
+};
+
+/**
+ * @brief Calculates the antinodes of all antenna groups in parallel, every thread marks into its
+ * own antinodes_t which are merged at the end.
+ */
+template<typename antinodes_t, typename calculate_t>
+antinodes_t collect_antinodes(const std::vector<antenna_pair>& antenna_pairs,
+                              const int64_t width,
+                              const int64_t height,
+                              calculate_t&& calculate) {
+    tbb::enumerable_thread_specific<antinodes_t> local_antinodes {[&]() {
+        return antinodes_t {width, height};
+    }};
+    tbb::parallel_for(tbb::blocked_range<std::size_t> {0U, antenna_pairs.size(), 1U},
+                      [&](const tbb::blocked_range<std::size_t>& range) {
+                          antinodes_t& antinodes = local_antinodes.local();
+                          for(std::size_t i = range.begin(); i != range.end(); ++i)
+                              calculate(antenna_pairs[i], antinodes);
+                      });
+
+    antinodes_t antinodes {width, height};
+    local_antinodes.combine_each([&](const antinodes_t& local) {
+        antinodes.merge(local);
+    });
     return antinodes;
 }
 
-std::size_t solve(const mat& map) {
-    map_width = map[0].size();
-    map_height = map.size();
-    std::vector<antenna_pair> antenna_pairs = ::get_antenna_pairs(map);
-    std::vector<antinode_pair> antinode_pairs;
-    mat map_new = map;
-    for(const auto& pair: antenna_pairs) {
-        antinode_pair anti_pair = calculate_antinode_positions(pair);
-        antinode_pairs.emplace_back(anti_pair);
+/**
+ * @brief Dimensions and antenna groups of a map, the only state the solvers of both stages read,
+ * so several maps can be solved concurrently.
+ */
+class antenna_map {
+  public:
+    explicit antenna_map(const mat& map) :
+        width_(map[0].size()),
+        height_(map.size()),
+        antenna_pairs_(::get_antenna_pairs(map)) {
     }
 
-    std::vector<position> antenna_positions;
-    std::vector<position> antinode_positions;
+    antenna_map(const int64_t width,
+                const int64_t height,
+                std::vector<antenna_pair> antenna_pairs) :
+        width_(width),
+        height_(height),
+        antenna_pairs_(std::move(antenna_pairs)) {
+    }
 
-    for(const auto& pair: antenna_pairs) {
-        antenna_positions.insert(
-            antenna_positions.end(), pair.positions.begin(), pair.positions.end());
+    [[nodiscard]] int64_t width() const {
+        return width_;
     }
-    for(const auto& pair: antinode_pairs) {
-        antinode_positions.insert(
-            antinode_positions.end(), pair.positions.begin(), pair.positions.end());
+
+    [[nodiscard]] int64_t height() const {
+        return height_;
     }
-    // remove duplicates among antinodes
-    std::sort(antinode_positions.begin(), antinode_positions.end());
-    // print_positions(antinode_positions, "after_sort.txt");
-    antinode_positions.erase(std::unique(antinode_positions.begin(), antinode_positions.end()),
-                             antinode_positions.end());
 
-    /*for(const position pos: antinode_positions) {
-        // if(map_new.at(pos.m).at(pos.n) == '.')
-        map_new[pos.m][pos.n] = '#';
+    [[nodiscard]] const std::vector<antenna_pair>& antenna_pairs() const {
+        return antenna_pairs_;
     }
-    print_map(map_new);*/
-    return antinode_positions.size();
+
+  private:
+    int64_t width_;
+    int64_t height_;
+    std::vector<antenna_pair> antenna_pairs_;
+};
+
+/**
+ * @brief Reads a map given as its dimensions followed by one antenna per line, "width height" on
+ * the first line and "a m,n" for an antenna of frequency a at row m and column n, so huge maps
+ * never need a cell by cell representation.
+ */
+antenna_map get_antenna_list(const fs::path& path) {
+    const fs::path ws_path = fs::canonical(path);
+    std::ifstream ifs {ws_path};
+    if(!ifs.good())
+        throw std::runtime_error("Unable to open " + ws_path.string());
+
+    int64_t width {};
+    int64_t height {};
+    constexpr int64_t max_dimension = std::numeric_limits<int32_t>::max();
+    if(!(ifs >> width >> height) || width <= 0 || height <= 0 || width > max_dimension
+       || height > max_dimension)
+        throw std::runtime_error("Invalid antenna list dimensions in " + ws_path.string());
+
+    std::array<std::vector<position>, 256U> buckets;
+    std::string line;
+    while(std::getline(ifs, line)) {
+        std::stringstream ss {line};
+        char frequency {};
+        char separator {};
+        position pos {};
+        if(!(ss >> frequency))
+            continue;
+        if(!(ss >> pos.m >> separator >> pos.n) || frequency == '.'
+           || !::is_position_in_bounds(pos, width, height))
+            throw std::runtime_error("Invalid antenna " + line + " in " + ws_path.string());
+        buckets[static_cast<unsigned char>(frequency)].push_back(pos);
+    }
+
+    std::vector<antenna_pair> pairs;
+    for(std::size_t frequency = 0U; frequency < buckets.size(); ++frequency) {
+        std::vector<position>& group = buckets[frequency];
+        if(group.empty())
+            continue;
+        // two antennas of a frequency on one cell have no direction to step along
+        std::sort(group.begin(), group.end());
+        if(std::adjacent_find(group.cbegin(), group.cend()) != group.cend())
+            throw std::runtime_error("Duplicate antenna in " + ws_path.string());
+        pairs.push_back(antenna_pair {.frequency = static_cast<char>(frequency),
+                                      .positions = std::move(group)});
+    }
+    return antenna_map {width, height, std::move(pairs)};
 }
+
+namespace stage_1 {
+/**
+ * @brief Counts the positions at the pair distance beyond either antenna of every pair.
+ */
+class solver {
+  public:
+    explicit solver(const antenna_map& map) : map_(map) {
+    }
+
+    /**
+     * @param sparse collect antinodes in a hash set instead of a bit per map cell
+     */
+    std::size_t solve(const bool sparse) const {
+        if(sparse)
+            return count_antinodes<antinode_set>();
+        return count_antinodes<antinode_grid>();
+    }
+
+  private:
+    template<typename antinodes_t>
+    std::size_t count_antinodes() const {
+        return ::collect_antinodes<antinodes_t>(
+                   map_.antenna_pairs(),
+                   map_.width(),
+                   map_.height(),
+                   [&](const antenna_pair& pair, antinodes_t& antinodes) {
+                       calculate_antinode_positions(pair, antinodes);
+                   })
+            .count();
+    }
+
+    template<typename antinodes_t>
+    void calculate_antinode_positions(const antenna_pair& pair, antinodes_t& antinodes) const {
+        const std::size_t antennas_sz = pair.positions.size();
+        const std::vector<position>& antennas = pair.positions;
+
+        for(std::size_t antenna_i = 0U; antenna_i < (antennas_sz - 1U); ++antenna_i) {
+            for(std::size_t antenna_j = antenna_i + 1U; antenna_j < antennas_sz; ++antenna_j) {
+                const int32_t distance_m = antennas[antenna_j].m - antennas[antenna_i].m;
+                const int32_t distance_n = antennas[antenna_j].n - antennas[antenna_i].n;
+
+                antinodes.mark(position {.m = antennas[antenna_i].m - distance_m,
+                                         .n = antennas[antenna_i].n - distance_n});
+                antinodes.mark(position {.m = antennas[antenna_j].m + distance_m,
+                                         .n = antennas[antenna_j].n + distance_n});
+            }
+        }
+    }
+
+    const antenna_map& map_;
+};
 }
 namespace stage_2 {
-int64_t map_width = 0;
-int64_t map_height = 0;
-int64_t map_diagonal = 0;
-
-antinode_pair calculate_antinode_positions(const antenna_pair& pair) {
-    const std::size_t antennas_sz = pair.positions.size();
-    const std::vector<position>& antennas = pair.positions;
-
-    antinode_pair antinodes {.frequency = pair.frequency, .positions = {}};
-
-    for(std::size_t antenna_i = 0U; antenna_i < (antennas_sz - 1U); ++antenna_i) {
-        for(std::size_t antenna_j = antenna_i + 1U; antenna_j < antennas_sz; ++antenna_j) {
-            const int64_t distance_m = antennas.at(antenna_j).m - antennas.at(antenna_i).m;
-            const int64_t distance_n = antennas.at(antenna_j).n - antennas.at(antenna_i).n;
-
-            for(int64_t n = 1;; ++n) {
-                const position antinode_1 {.m = antennas.at(antenna_i).m - n * distance_m,
-                                           .n = antennas.at(antenna_i).n - n * distance_n};
-                if(!::is_position_in_bounds(antinode_1, map_width, map_height))
-                    break;
-                antinodes.positions.emplace_back(antinode_1);
-            }
-            for(int64_t n = 1;; ++n) {
-                const position antinode_2 {.m = antennas.at(antenna_j).m + n * distance_m,
-                                           .n = antennas.at(antenna_j).n + n * distance_n};
-                if(!::is_position_in_bounds(antinode_2, map_width, map_height))
-                    break;
-                antinodes.positions.emplace_back(antinode_2);
+/**
+ * @brief Range [first, last] of k for which origin + k * step lies within [0, size).
+ */
+std::pair<int64_t, int64_t>
+    step_range(const int64_t origin, const int64_t step, const int64_t size) {
+    if(step > 0)
+        return {-(origin / step), (size - 1 - origin) / step};
+    if(step < 0)
+        return {-((size - 1 - origin) / -step), origin / -step};
+    return {std::numeric_limits<int64_t>::min(), std::numeric_limits<int64_t>::max()};
+}
+
+/**
+ * @brief Counts the grid positions in line with at least two antennas of the same frequency.
+ */
+class solver {
+  public:
+    explicit solver(const antenna_map& map) : map_(map) {
+    }
+
+    /**
+     * @param sparse collect antinodes in a hash set instead of a bit per map cell
+     */
+    std::size_t solve(const bool sparse) const {
+        if(sparse)
+            return count_antinodes<antinode_set>();
+        return count_antinodes<antinode_grid>();
+    }
+
+  private:
+    template<typename antinodes_t>
+    std::size_t count_antinodes() const {
+        return ::collect_antinodes<antinodes_t>(
+                   map_.antenna_pairs(),
+                   map_.width(),
+                   map_.height(),
+                   [&](const antenna_pair& pair, antinodes_t& antinodes) {
+                       // the line through a pair includes both antennas, so an antenna is an
+                       // antinode exactly when it shares its frequency with another one
+                       calculate_antinode_positions(pair, antinodes);
+                   })
+            .count();
+    }
+
+    /**
+     * @brief Marks every grid position on the line through each pair of antennas. The step
+     * between the antennas is reduced by its gcd and the in bounds range of steps is computed up
+     * front, so no position has to be bounds checked.
+     */
+    template<typename antinodes_t>
+    void calculate_antinode_positions(const antenna_pair& pair, antinodes_t& antinodes) const {
+        const std::size_t antennas_sz = pair.positions.size();
+        const std::vector<position>& antennas = pair.positions;
+
+        for(std::size_t antenna_i = 0U; antenna_i < (antennas_sz - 1U); ++antenna_i) {
+            for(std::size_t antenna_j = antenna_i + 1U; antenna_j < antennas_sz; ++antenna_j) {
+                const int32_t distance_m = antennas[antenna_j].m - antennas[antenna_i].m;
+                const int32_t distance_n = antennas[antenna_j].n - antennas[antenna_i].n;
+                const int32_t divisor = std::gcd(distance_m, distance_n);
+                const int32_t step_m = distance_m / divisor;
+                const int32_t step_n = distance_n / divisor;
+
+                const position& origin = antennas[antenna_i];
+                const auto [first_m, last_m] = step_range(origin.m, step_m, map_.height());
+                const auto [first_n, last_n] = step_range(origin.n, step_n, map_.width());
+                const int64_t last = std::min(last_m, last_n);
+                for(int64_t k = std::max(first_m, first_n); k <= last; ++k) {
+                    antinodes.mark_unchecked(
+                        position {.m = static_cast<int32_t>(origin.m + k * step_m),
+                                  .n = static_cast<int32_t>(origin.n + k * step_n)});
+                }
             }
         }
     }
-    return antinodes;
+
+    const antenna_map& map_;
+};
 }
 
-std::size_t solve(const mat& map) {
-    map_width = map[0].size();
-    map_height = map.size();
+enum class antinode_rule {
+    nearest,     //!< stage 1, the two positions at the pair distance beyond either antenna
+    harmonic,    //!< stage 2, every grid position on the line through both antennas
+};
 
-    map_diagonal = std::sqrt(map_width * map_width + map_height * map_height);
-    std::vector<antenna_pair> antenna_pairs = ::get_antenna_pairs(map);
-    std::vector<antinode_pair> antinode_pairs;
-    mat map_new = map;
-    for(const auto& pair: antenna_pairs) {
-        antinode_pair anti_pair = calculate_antinode_positions(pair);
-        antinode_pairs.emplace_back(anti_pair);
+/**
+ * @brief Keeps the unique antinode count of a changing set of antennas. Every cell counts the
+ * antenna pairs producing an antinode on it, so adding or removing an antenna only walks the pairs
+ * within its own frequency group and the unique count changes when a cell moves between 0 and 1.
+ */
+class antinode_tracker {
+  public:
+    antinode_tracker(const int64_t width, const int64_t height, const antinode_rule rule) :
+        width_(width),
+        height_(height),
+        rule_(rule),
+        references_(static_cast<std::size_t>(width * height), 0U) {
     }
 
-    std::vector<position> antinode_positions;
+    antinode_tracker(const mat& map, const antinode_rule rule) :
+        antinode_tracker(map[0].size(), map.size(), rule) {
+        for(const antenna_pair& pair: ::get_antenna_pairs(map)) {
+            for(const position& pos: pair.positions)
+                add(pair.frequency, pos);
+        }
+    }
 
-    // antenna's also become antinodes in this example
-    for(const auto& pair: antenna_pairs) {
-        antinode_positions.insert(
-            antinode_positions.end(), pair.positions.begin(), pair.positions.end());
+    /**
+     * @return false if the position is out of bounds or already holds an antenna of the frequency
+     */
+    bool add(const char frequency, const position& pos) {
+        std::vector<position>& group = groups_[static_cast<unsigned char>(frequency)];
+        if(!::is_position_in_bounds(pos, width_, height_) || ::is_duplicate_position(group, pos))
+            return false;
+        for(const position& other: group)
+            update_pair(pos, other, 1);
+        group.push_back(pos);
+        return true;
     }
-    for(const auto& pair: antinode_pairs) {
-        antinode_positions.insert(
-            antinode_positions.end(), pair.positions.begin(), pair.positions.end());
+
+    /**
+     * @return false if there is no antenna of the frequency at the position
+     */
+    bool remove(const char frequency, const position& pos) {
+        std::vector<position>& group = groups_[static_cast<unsigned char>(frequency)];
+        const auto it = std::find(group.begin(), group.end(), pos);
+        if(it == group.end())
+            return false;
+        *it = group.back();
+        group.pop_back();
+        for(const position& other: group)
+            update_pair(pos, other, -1);
+        return true;
     }
 
-    // remove duplicates among antinodes
-    std::sort(antinode_positions.begin(), antinode_positions.end());
-    antinode_positions.erase(std::unique(antinode_positions.begin(), antinode_positions.end()),
-                             antinode_positions.end());
+    /**
+     * @return false if there is no antenna of the frequency at from or it can't be added at to,
+     * the antennas are left untouched then
+     */
+    bool move(const char frequency, const position& from, const position& to) {
+        const std::vector<position>& group = groups_[static_cast<unsigned char>(frequency)];
+        if(!::is_duplicate_position(group, from))
+            return false;
+        if(from == to)
+            return true;
+        if(!::is_position_in_bounds(to, width_, height_) || ::is_duplicate_position(group, to))
+            return false;
+        remove(frequency, from);
+        add(frequency, to);
+        return true;
+    }
 
-    /*for(const position pos: antinode_positions) {
-        // if(map_new.at(pos.m).at(pos.n) == '.')
-        map_new[pos.m][pos.n] = '#';
+    [[nodiscard]] std::size_t count() const {
+        return unique_count_;
     }
-    print_map(map_new);*/
 
-    return antinode_positions.size();
-}
-}
+  private:
+    void update_pair(const position& a, const position& b, const int32_t delta) {
+        const int32_t distance_m = b.m - a.m;
+        const int32_t distance_n = b.n - a.n;
 
-int main(int argc, char** argv) {
-    if(argc < 2U) {
-        std::cout << "Invalid number of arguments\n";
-        return 1;
+        if(rule_ == antinode_rule::nearest) {
+            update_cell(position {.m = a.m - distance_m, .n = a.n - distance_n}, delta);
+            update_cell(position {.m = b.m + distance_m, .n = b.n + distance_n}, delta);
+            return;
+        }
+
+        const int32_t divisor = std::gcd(distance_m, distance_n);
+        const int32_t step_m = distance_m / divisor;
+        const int32_t step_n = distance_n / divisor;
+        const auto [first_m, last_m] = stage_2::step_range(a.m, step_m, height_);
+        const auto [first_n, last_n] = stage_2::step_range(a.n, step_n, width_);
+        const int64_t last = std::min(last_m, last_n);
+        for(int64_t k = std::max(first_m, first_n); k <= last; ++k) {
+            update_cell(position {.m = static_cast<int32_t>(a.m + k * step_m),
+                                  .n = static_cast<int32_t>(a.n + k * step_n)},
+                        delta);
+        }
+    }
+
+    void update_cell(const position& pos, const int32_t delta) {
+        if(!::is_position_in_bounds(pos, width_, height_))
+            return;
+        uint32_t& references = references_[static_cast<std::size_t>(pos.m) * width_ + pos.n];
+        if(delta > 0 && references++ == 0U)
+            ++unique_count_;
+        else if(delta < 0 && --references == 0U)
+            --unique_count_;
     }
 
-    mat map = get_map(argv[1]);
+    int64_t width_;
+    int64_t height_;
+    antinode_rule rule_;
+    std::array<std::vector<position>, 256U> groups_;    //!< antennas per frequency byte
+    std::vector<uint32_t> references_;                  //!< antenna pairs per cell
+    std::size_t unique_count_ {};
+};
+
+struct map_result {
+    int64_t width;
+    int64_t height;
+    std::size_t stage_1;
+    std::size_t stage_2;
+    std::chrono::microseconds t_stage_1;
+    std::chrono::microseconds t_stage_2;
+    std::string error;
+};
 
+/**
+ * @param antenna_list the map is given as an antenna list, see get_antenna_list
+ * @param incremental count through antinode_tracker by adding the antennas one at a time, needs
+ * a map given cell by cell
+ */
+map_result solve_map(const fs::path& path,
+                     const bool antenna_list,
+                     const bool sparse,
+                     const bool incremental) {
+    map_result result {};
     try {
+        std::optional<mat> map;
+        if(!antenna_list)
+            map = get_map(path);
+        const antenna_map antennas = map ? antenna_map {*map} : get_antenna_list(path);
         std::chrono::time_point<std::chrono::high_resolution_clock> start =
             std::chrono::high_resolution_clock::now();
-        uint32_t result_stage_1 = stage_1::solve(map);
-        std::chrono::microseconds t_stage_1 = std::chrono::duration_cast<std::chrono::microseconds>(
+        result.stage_1 = incremental ? antinode_tracker {*map, antinode_rule::nearest}.count()
+                                     : stage_1::solver {antennas}.solve(sparse);
+        result.t_stage_1 = std::chrono::duration_cast<std::chrono::microseconds>(
             std::chrono::high_resolution_clock::now() - start);
 
         start = std::chrono::high_resolution_clock::now();
-        uint32_t result_stage_2 = stage_2::solve(map);
-        std::chrono::microseconds t_stage_2 = std::chrono::duration_cast<std::chrono::microseconds>(
+        result.stage_2 = incremental ? antinode_tracker {*map, antinode_rule::harmonic}.count()
+                                     : stage_2::solver {antennas}.solve(sparse);
+        result.t_stage_2 = std::chrono::duration_cast<std::chrono::microseconds>(
             std::chrono::high_resolution_clock::now() - start);
-        std::cout << std::format(
-            "Map dimension (wxh): {}x{}\n", stage_1::map_width, stage_1::map_height);
-        std::cout << std::format("Stage 1 result: {} solved in {} us\n", result_stage_1, t_stage_1);
-        std::cout << std::format("Stage 2 result: {} solved in {} us\n", result_stage_2, t_stage_2);
+        result.width = antennas.width();
+        result.height = antennas.height();
     } catch(const std::exception& e) {
-        std::cout << e.what() << "\n";
+        result.error = e.what();
     }
+    return result;
 }
 
-std::vector<antenna_pair> get_antenna_pairs(const mat& map) {
-    std::vector<antenna_pair> pairs;
-    const std::size_t rows = map.size();
-    const std::size_t cols = map[0].size();
-
-    for(std::size_t m = 0U; m < rows; ++m) {
-        for(std::size_t n = 0U; n < cols; ++n) {
-            if(auto it = std::find_if(pairs.begin(),
-                                      pairs.end(),
-                                      [&](const antenna_pair& a_pair) {
-                                          return map.at(m).at(n) == a_pair.frequency;
-                                      });
-               it != pairs.end()) {
-                it->positions.push_back(
-                    position {.m = static_cast<int64_t>(m), .n = static_cast<int64_t>(n)});
-            } else {
-                if(!(map.at(m).at(n) == '.'))
-                    pairs.push_back(
-                        antenna_pair {.frequency = map[m][n],
-                                      .positions = {position {.m = static_cast<int64_t>(m),
-                                                              .n = static_cast<int64_t>(n)}}});
+/**
+ * @brief Applies antenna changes from a file with one change per line, "+a m,n" adds and "-a m,n"
+ * removes an antenna of frequency a at row m and column n, "~a m,n m',n'" moves it. After every
+ * change the tracked counts are printed.
+ * @param verify additionally recompute both stages on the changed map after every change
+ */
+void apply_antenna_changes(mat& map, const fs::path& path, const bool verify) {
+    const fs::path ws_path = fs::canonical(path);
+    std::ifstream ifs {ws_path};
+    if(!ifs.good())
+        throw std::runtime_error("Unable to open " + ws_path.string());
+
+    const int32_t height = map.size();
+    const int32_t width = map[0].size();
+    const auto is_free = [&](const position& pos) {
+        return ::is_position_in_bounds(pos, width, height) && map[pos.m][pos.n] == '.';
+    };
+    const auto holds = [&](const position& pos, const char frequency) {
+        return ::is_position_in_bounds(pos, width, height) && map[pos.m][pos.n] == frequency;
+    };
+
+    antinode_tracker nearest {map, antinode_rule::nearest};
+    antinode_tracker harmonic {map, antinode_rule::harmonic};
+    std::string line;
+    while(std::getline(ifs, line)) {
+        std::stringstream ss {line};
+        char operation {};
+        char frequency {};
+        char separator {};
+        position from {};
+        position to {};
+        if(!(ss >> operation >> frequency >> from.m >> separator >> from.n) || frequency == '.')
+            continue;
+
+        bool applied = false;
+        if(operation == '+' && is_free(from)) {
+            applied = nearest.add(frequency, from) && harmonic.add(frequency, from);
+            if(applied)
+                map[from.m][from.n] = frequency;
+        } else if(operation == '-' && holds(from, frequency)) {
+            applied = nearest.remove(frequency, from) && harmonic.remove(frequency, from);
+            if(applied)
+                map[from.m][from.n] = '.';
+        } else if(operation == '~' && (ss >> to.m >> separator >> to.n) && holds(from, frequency)
+                  && is_free(to)) {
+            applied = nearest.move(frequency, from, to) && harmonic.move(frequency, from, to);
+            if(applied) {
+                map[from.m][from.n] = '.';
+                map[to.m][to.n] = frequency;
             }
         }
+        if(!applied) {
+            std::cout << "\n[ERROR]: " << line << " doesn't match the map, skipped\n";
+            continue;
+        }
+
+        std::cout << std::format("\nAfter {}:\n", line);
+        if(!verify) {
+            std::cout << std::format("Stage 1 result: {}\n", nearest.count());
+            std::cout << std::format("Stage 2 result: {}\n", harmonic.count());
+            continue;
+        }
+        const antenna_map antennas {map};
+        std::cout << std::format("Stage 1 result: {} (recomputed {})\n",
+                                 nearest.count(),
+                                 stage_1::solver {antennas}.solve(false));
+        std::cout << std::format("Stage 2 result: {} (recomputed {})\n",
+                                 harmonic.count(),
+                                 stage_2::solver {antennas}.solve(false));
+    }
+}
+
+int main(int argc, char** argv) {
+    if(argc < 2U) {
+        std::cout << "Invalid number of arguments\n";
+        return 1;
+    }
+
+    // every argument is a map to solve, "antennas" reads the maps as antenna lists, "sparse"
+    // selects the hash set backend, "incremental" counts both stages through antinode_tracker and
+    // "changes <file>" applies antenna changes to a single map afterwards, "verify" recomputes
+    // the map after each change
+    std::vector<fs::path> paths;
+    std::optional<fs::path> changes_path;
+    bool antenna_list = false;
+    bool sparse = false;
+    bool incremental = false;
+    bool verify = false;
+    for(int arg_i = 1; arg_i < argc; ++arg_i) {
+        if(std::string {argv[arg_i]} == "antennas")
+            antenna_list = true;
+        else if(std::string {argv[arg_i]} == "sparse")
+            sparse = true;
+        else if(std::string {argv[arg_i]} == "incremental")
+            incremental = true;
+        else if(std::string {argv[arg_i]} == "verify")
+            verify = true;
+        else if(std::string {argv[arg_i]} == "changes" && arg_i + 1 < argc)
+            changes_path = argv[++arg_i];
+        else
+            paths.emplace_back(argv[arg_i]);
+    }
+    if(changes_path && paths.size() != 1U) {
+        std::cout << "Antenna changes need exactly one map\n";
+        return 1;
+    }
+    if(antenna_list && (incremental || changes_path)) {
+        std::cout << "Antenna lists can't be tracked incrementally\n";
+        return 1;
+    }
+
+    std::vector<map_result> results(paths.size());
+    tbb::parallel_for(std::size_t {}, paths.size(), [&](const std::size_t i) {
+        results[i] = solve_map(paths[i], antenna_list, sparse, incremental);
+    });
+
+    for(std::size_t i = 0U; i < paths.size(); ++i) {
+        const map_result& result = results[i];
+        if(paths.size() > 1U)
+            std::cout << paths[i].string() << "\n";
+        if(!result.error.empty()) {
+            std::cout << result.error << "\n";
+            continue;
+        }
+        std::cout << std::format("Map dimension (wxh): {}x{}\n", result.width, result.height);
+        std::cout << std::format(
+            "Stage 1 result: {} solved in {} us\n", result.stage_1, result.t_stage_1);
+        std::cout << std::format(
+            "Stage 2 result: {} solved in {} us\n", result.stage_2, result.t_stage_2);
+    }
+
+    if(changes_path && results.front().error.empty()) {
+        try {
+            mat map = get_map(paths.front());
+            apply_antenna_changes(map, *changes_path, verify);
+        } catch(const std::exception& e) {
+            std::cout << e.what() << "\n";
+            return 1;
+        }
+    }
+}
+
+std::vector<antenna_pair> get_antenna_pairs(const mat& map) {
+    // one bucket per possible frequency byte, so grouping needs no searching
+    std::array<std::vector<position>, 256U> buckets;
+    const int32_t rows = map.size();
+
+    for(int32_t m = 0; m < rows; ++m) {
+        const std::vector<char>& row = map[m];
+        const int32_t cols = row.size();
+        for(int32_t n = 0; n < cols; ++n) {
+            if(row[n] != '.')
+                buckets[static_cast<unsigned char>(row[n])].push_back(position {.m = m, .n = n});
+        }
+    }
+
+    std::vector<antenna_pair> pairs;
+    for(std::size_t frequency = 0U; frequency < buckets.size(); ++frequency) {
+        if(!buckets[frequency].empty())
+            pairs.push_back(antenna_pair {.frequency = static_cast<char>(frequency),
+                                          .positions = std::move(buckets[frequency])});
     }
     return pairs;
 }
@@ -1,9 +1,11 @@
 #include <algorithm>
+#include <array>
 #include <chrono>
 #include <cstddef>
 #include <cstdint>
 #include <filesystem>
 #include <format>
+#include <functional>
 #include <fstream>
 #include <ios>
 #include <iostream>
@@ -11,37 +13,133 @@
 #include <limits>
 #include <numeric>
 #include <optional>
+#include <queue>
 #include <stdexcept>
+#include <string>
 #include <vector>
 
+#include <tbb/blocked_range.h>
+#include <tbb/parallel_reduce.h>
+#include <tbb/parallel_scan.h>
+
 namespace fs = std::filesystem;
 std::vector<char> get_input(const fs::path& path);
 
 void print_vec(const std::vector<uint64_t>& vec, std::optional<fs::path> path) {
     if(path) {
-        std::ofstream ofs {fs::canonical(*path)};
+        std::ofstream ofs {fs::weakly_canonical(*path)};
         std::for_each(vec.begin(), vec.end(), [&](const uint64_t i) {
             ofs << i << "\n";
         });
     }
 }
-std::vector<uint64_t> decompress_disk_map(const std::vector<char>& disk_map) {
-    uint64_t id {};
-    std::vector<uint64_t> decompressed {};
-    const std::size_t disk_map_sz = disk_map.size();
-    for(std::size_t i = 0U; i < disk_map_sz; ++i) {
-        std::uint64_t push_back_v {};
-        if(i & 0x1) {
-            push_back_v = std::numeric_limits<uint64_t>::max();
-        } else {
-            push_back_v = id;
-            ++id;
+/**
+ * @brief One file of the disk map together with the free gap that follows it.
+ */
+struct disk_run {
+    uint64_t id;
+    uint64_t pos;    //!< first block of the file
+    uint8_t file_size;
+    uint8_t gap_size;    //!< 0 behind the last file when the map has no trailing gap
+};
+
+/**
+ * @brief Decodes run id, the file at digit 2 * id and the gap after it, whose file starts at
+ * block pos.
+ */
+[[nodiscard]] disk_run
+    decode_run(const std::vector<char>& disk_map, const std::size_t id, const uint64_t pos) {
+    const std::size_t file_i = 2U * id;
+    const bool has_gap = file_i + 1U < disk_map.size();
+    return disk_run {.id = id,
+                     .pos = pos,
+                     .file_size = static_cast<uint8_t>(disk_map[file_i]),
+                     .gap_size = static_cast<uint8_t>(has_gap ? disk_map[file_i + 1U] : 0)};
+}
+
+//! number of (file, gap) runs in the disk map
+[[nodiscard]] std::size_t run_count(const std::vector<char>& disk_map) {
+    return (disk_map.size() + 1U) / 2U;
+}
+
+/**
+ * @brief Walks the disk map as (file run, gap run) pairs, keeping track of the block position.
+ */
+class disk_runs {
+  public:
+    class iterator {
+      public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = disk_run;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const disk_run*;
+        using reference = const disk_run&;
+
+        iterator() = default;
+        iterator(const std::vector<char>* disk_map, const std::size_t id) :
+            disk_map_(disk_map),
+            id_(id) {
+            load(0U);
+        }
+
+        reference operator*() const {
+            return run_;
+        }
+
+        pointer operator->() const {
+            return &run_;
+        }
+
+        iterator& operator++() {
+            ++id_;
+            load(run_.pos + run_.file_size + run_.gap_size);
+            return *this;
+        }
+
+        iterator operator++(int) {
+            iterator previous = *this;
+            ++*this;
+            return previous;
         }
-        for(std::size_t j = 0U; j < disk_map.at(i); ++j) {
-            decompressed.push_back(push_back_v);
+
+        bool operator==(const iterator& rhs) const {
+            return id_ == rhs.id_;
+        }
+
+      private:
+        void load(const uint64_t pos) {
+            if(id_ < ::run_count(*disk_map_))
+                run_ = ::decode_run(*disk_map_, id_, pos);
         }
+
+        const std::vector<char>* disk_map_ {};
+        std::size_t id_ {};
+        disk_run run_ {};
+    };
+
+    explicit disk_runs(const std::vector<char>& disk_map) :
+        disk_map_(disk_map) {
     }
-    return decompressed;
+
+    [[nodiscard]] iterator begin() const {
+        return iterator {&disk_map_, 0U};
+    }
+
+    [[nodiscard]] iterator end() const {
+        return iterator {&disk_map_, ::run_count(disk_map_)};
+    }
+
+  private:
+    const std::vector<char>& disk_map_;
+};
+
+/**
+ * @brief Checksum of a run of size blocks of file id starting at position, id * (position + ... +
+ * position + size - 1) as an arithmetic series.
+ */
+[[nodiscard]] uint64_t
+    run_checksum(const uint64_t id, const uint64_t position, const uint64_t size) {
+    return id * (position * size + size * (size - 1U) / 2U);
 }
 
 namespace stage_1 {
@@ -59,133 +157,172 @@ uint64_t solve(const std::vector<char>& disk_map) {
                              drive_sz,
                              max_file_id);
 
-    std::vector<uint64_t> decompressed = ::decompress_disk_map(disk_map);
-    const std::size_t decompressed_sz = decompressed.size();
-
-    // print_vec(decompressed, "pre-sorted.txt");
-
-    std::size_t start_index {};    // prevents search from the very beginning at every loop
-    for(std::size_t i = decompressed_sz - 1U; i >= 0U; --i) {
-        if(i < start_index) {
-            break;
+    // files are taken from the back and fill the gaps from the front, each run is summed in closed
+    // form so the disk is never expanded into blocks
+    std::size_t front {};
+    std::size_t back = (disk_map_sz - 1U) & ~std::size_t {1U};
+    uint64_t back_remaining = disk_map[back];
+    uint64_t position {};
+    uint64_t checksum {};
+    while(front < back) {
+        if(!(front & 0x1U)) {
+            checksum += ::run_checksum(front / 2U, position, disk_map[front]);
+            position += disk_map[front];
+            ++front;
+            continue;
         }
-        if(decompressed.at(i) != std::numeric_limits<uint64_t>::max()) {
-            for(std::size_t j = start_index; j < i; ++j) {
-                if(decompressed.at(j) == std::numeric_limits<uint64_t>::max()) {
-                    std::swap(decompressed[i], decompressed[j]);
-                    start_index = j;
-                    break;
-                }
+        uint64_t gap = disk_map[front];
+        while(gap > 0U && front < back) {
+            const uint64_t moved = std::min(gap, back_remaining);
+            checksum += ::run_checksum(back / 2U, position, moved);
+            position += moved;
+            gap -= moved;
+            back_remaining -= moved;
+            if(back_remaining == 0U) {
+                back -= 2U;
+                back_remaining = disk_map[back];
             }
         }
+        ++front;
     }
-
-    uint64_t checksum {};
-    // print_vec(decompressed, "post-sorted.txt");
-    for(std::size_t i = 0U; i < decompressed_sz; ++i) {
-        if(decompressed[i] == std::numeric_limits<uint64_t>::max())
-            break;
-        checksum += decompressed[i] * i;
-    }
+    // the file both pointers ended on keeps whatever was not moved
+    if(front == back)
+        checksum += ::run_checksum(back / 2U, position, back_remaining);
     return checksum;
 }
 }
 namespace stage_2 {
 enum class block_t : uint32_t { file, free_mem };
-struct file_entry {
-    int64_t id;
-    std::size_t pos;
-    std::size_t size;
-};
-using file_table = std::vector<file_entry>;
+//! block position of every file indexed by its id, sizes stay in the disk map
+using file_positions = std::vector<uint64_t>;
+
+//! below this many runs the serial walk beats spawning tasks
+constexpr std::size_t parallel_threshold = 1U << 16U;
+constexpr std::size_t parallel_grain = 1U << 14U;
+
+file_positions generate_file_positions(const std::vector<char>& disk_map) {
+    file_positions positions(::run_count(disk_map));
+    if(disk_map.size() < parallel_threshold) {
+        for(const disk_run& run: ::disk_runs {disk_map})
+            positions[run.id] = run.pos;
+        return positions;
+    }
+
+    // the position of every run is an exclusive prefix sum over the run sizes, computed blockwise
+    // in parallel with the same decoding the serial walk uses
+    tbb::parallel_scan(
+        tbb::blocked_range<std::size_t> {0U, positions.size(), parallel_grain},
+        uint64_t {},
+        [&](const tbb::blocked_range<std::size_t>& range, uint64_t position, const bool is_final) {
+            for(std::size_t id = range.begin(); id != range.end(); ++id) {
+                const disk_run run = ::decode_run(disk_map, id, position);
+                if(is_final)
+                    positions[id] = run.pos;
+                position += run.file_size + run.gap_size;
+            }
+            return position;
+        },
+        std::plus<> {});
+    return positions;
 }
 
-template<>
-struct ::std::formatter<stage_2::file_entry> : ::std::formatter<std::string> {
-    auto format(stage_2::file_entry f, format_context& ctx) const {
-        return formatter<string>::format(
-            std::format("ID: {} Pos: {} Size: {}", f.id, f.pos, f.size), ctx);
+/**
+ * @brief Sum of the file run checksums, reduced in parallel for large maps.
+ */
+uint64_t checksum(const std::vector<char>& disk_map, const file_positions& positions) {
+    const auto sum_range = [&](const tbb::blocked_range<std::size_t>& range, uint64_t sum) {
+        for(std::size_t id = range.begin(); id != range.end(); ++id)
+            sum += ::run_checksum(id, positions[id], disk_map[2U * id]);
+        return sum;
+    };
+    if(disk_map.size() < parallel_threshold)
+        return sum_range(tbb::blocked_range<std::size_t> {0U, positions.size()}, 0U);
+    return tbb::parallel_reduce(
+        tbb::blocked_range<std::size_t> {0U, positions.size(), parallel_grain},
+        uint64_t {},
+        sum_range,
+        std::plus<> {});
+}
+
+/**
+ * @brief Free spans bucketed by size, one min-heap of start positions per size. Runs are single
+ * digits, so the leftmost span fitting a file is the smallest top among at most nine heaps.
+ */
+class free_span_index {
+  public:
+    explicit free_span_index(const std::vector<char>& disk_map) {
+        for(const disk_run& run: ::disk_runs {disk_map}) {
+            if(run.gap_size > 0U)
+                spans_[run.gap_size].push(run.pos + run.file_size);
+        }
     }
-};
 
-namespace stage_2 {
-file_table generate_file_table(const std::vector<char>& disk_map) {
-    file_table table;
-    table.reserve(disk_map.size());
-    const std::size_t disk_map_sz = disk_map.size();
-    std::size_t position {};
-    int64_t id {};
-    for(std::size_t i = 0U; i < disk_map_sz; ++i) {
-        file_entry entry {.id = (i & 0x1U) ? -1 : id++,
-                          .pos = position,
-                          .size = static_cast<std::size_t>(disk_map[i])};
-        position += entry.size;
-        table.push_back(entry);
+    /**
+     * @brief Takes the leftmost span of at least size blocks that starts before limit, the
+     * unused tail of the span is put back under its new size.
+     * @return start position of the taken span
+     */
+    std::optional<uint64_t> take(const std::size_t size, const uint64_t limit) {
+        std::size_t best_size {};
+        uint64_t best_pos = limit;
+        for(std::size_t span_size = size; span_size <= max_span_size; ++span_size) {
+            if(!spans_[span_size].empty() && spans_[span_size].top() < best_pos) {
+                best_pos = spans_[span_size].top();
+                best_size = span_size;
+            }
+        }
+        if(best_pos == limit)
+            return std::nullopt;
+
+        spans_[best_size].pop();
+        if(best_size > size)
+            spans_[best_size - size].push(best_pos + size);
+        return best_pos;
     }
-    return table;
+
+  private:
+    static constexpr std::size_t max_span_size = 9U;
+    std::array<std::priority_queue<uint64_t, std::vector<uint64_t>, std::greater<>>,
+               max_span_size + 1U>
+        spans_;
+};
+
+/**
+ * @brief Expands the files into one entry per block, free blocks hold the maximum value. Only
+ * needed to dump the layout.
+ */
+std::vector<uint64_t> decompress_file_positions(const std::vector<char>& disk_map,
+                                                const file_positions& positions) {
+    std::vector<uint64_t> decompressed(
+        std::accumulate(disk_map.cbegin(), disk_map.cend(), std::size_t {}),
+        std::numeric_limits<uint64_t>::max());
+    for(std::size_t id = 0U; id < positions.size(); ++id)
+        std::fill_n(decompressed.begin() + positions[id], disk_map[2U * id], id);
+    return decompressed;
 }
 
-uint64_t solve(const std::vector<char>& disk_map) {
+/**
+ * @param dump_path optionally writes the compacted disk with one block per line
+ */
+uint64_t solve(const std::vector<char>& disk_map, const std::optional<fs::path>& dump_path) {
     if(disk_map.empty())
         throw std::runtime_error("Zero length isn't accepted!");
-    std::vector<uint64_t> decompressed = ::decompress_disk_map(disk_map);
-    file_table f_table = generate_file_table(disk_map);
-    if(f_table.size() != disk_map.size())
-        throw std::runtime_error("Invalid file table generated!");
-
-    const std::size_t file_table_sz = f_table.size();
-    // print_vec(decompressed, "pre-sorted.txt");
-    for(int64_t i = file_table_sz - 1; i >= 0U; --i) {
-        if(f_table.at(i).id < 0U)
-            continue;
-        auto it = std::find_if(f_table.begin(), f_table.begin() + i, [&](const file_entry& fe) {
-            return (fe.id < 0U) && (fe.size >= f_table.at(i).size);
-        });
-        if(it != (f_table.begin() + i)) {
-            /*std::cout << "Copying range [";
-            std::for_each(decompressed.begin() + f_table.at(i).pos,
-                          decompressed.begin() + f_table.at(i).pos + f_table.at(i).size,
-                          [&](const auto& e) {
-                              std::cout << e << ", ";
-                          });
-            std::cout << "] from position " << f_table.at(i).pos << " to " << it->pos << "\n";
-            */
-            std::copy(decompressed.begin() + f_table.at(i).pos,
-                      decompressed.begin() + f_table.at(i).pos + f_table.at(i).size,
-                      decompressed.begin() + it->pos);
-            // update source file entry from where we copied
-            // move block data at end
-            std::fill_n(decompressed.begin() + f_table.at(i).pos,
-                        f_table.at(i).size,
-                        std::numeric_limits<uint64_t>::max());
-
-            // new slot of empty memory that has to be added to the file table
-            file_entry fe {.id = -1,
-                           .pos = it->pos + f_table.at(i).size,
-                           .size = it->size - f_table.at(i).size};
-            // update destiantion file entry
-            const std::size_t block_sz = it->size;
-            it->id = f_table.at(i).id;
-            it->size = f_table.at(i).size;
-
-            if(f_table.at(i).size < block_sz) {
-                // std::cout << std::format("Inserting new slot {}\n", fe);
-                f_table.insert(it + 1, fe);
-            }
+    // besides the disk map itself only a position per file and one per gap are kept
+    file_positions positions = generate_file_positions(disk_map);
+    free_span_index free_spans {disk_map};
 
-            f_table.at(i).id = -1;
-        }
+    for(std::size_t id = positions.size(); id-- > 0U;) {
+        const std::size_t size = static_cast<std::size_t>(disk_map[2U * id]);
+        if(size == 0U)
+            continue;
+        if(const std::optional<uint64_t> target = free_spans.take(size, positions[id]))
+            positions[id] = *target;
     }
 
-    uint64_t checksum {};
-    const std::size_t decompressed_sz = decompressed.size();
-    print_vec(decompressed, "post-sorted.txt");
-    for(std::size_t i = 0U; i < decompressed_sz; ++i) {
-        if(decompressed[i] != std::numeric_limits<uint64_t>::max())
-            checksum += decompressed[i] * i;
-    }
+    if(dump_path)
+        print_vec(decompress_file_positions(disk_map, positions), dump_path);
 
-    return checksum;
+    return checksum(disk_map, positions);
 }
 }
 
@@ -194,8 +331,12 @@ int main(int argc, char** argv) {
         std::cout << "Invalid number of arguments\n";
         return 1;
     }
-    std::vector<char> disk_map = get_input(argv[1]);
+    // "dump" writes the compacted disk of stage 2 to post-sorted.txt
+    std::optional<fs::path> dump_path;
+    if(argc > 2 && std::string {argv[2]} == "dump")
+        dump_path = "post-sorted.txt";
     try {
+        const std::vector<char> disk_map = get_input(argv[1]);
         std::chrono::time_point<std::chrono::high_resolution_clock> start =
             std::chrono::high_resolution_clock::now();
         uint64_t sol_stage_1 = stage_1::solve(disk_map);
@@ -205,7 +346,7 @@ int main(int argc, char** argv) {
 
         start = std::chrono::high_resolution_clock::now();
 
-        uint64_t sol_stage_2 = stage_2::solve(disk_map);
+        uint64_t sol_stage_2 = stage_2::solve(disk_map, dump_path);
         const std::chrono::microseconds t_stage_2 =
             std::chrono::duration_cast<std::chrono::microseconds>(
                 std::chrono::high_resolution_clock::now() - start);
@@ -225,15 +366,25 @@ int main(int argc, char** argv) {
 
 std::vector<char> get_input(const fs::path& path) {
     const auto ws_path = fs::canonical(path);
-    std::ifstream ifs {ws_path};
+    std::ifstream ifs {ws_path, std::ios::binary};
     if(!ifs.good())
         throw std::runtime_error("Unable to open file " + ws_path.string());
-    std::string line;
-    std::getline(ifs, line);
+
+    // digits are decoded chunk by chunk straight into the disk map, so the text is never held as a
+    // whole next to it
     std::vector<char> disk_map;
-    disk_map.reserve(line.size());
-    std::for_each(line.cbegin(), line.cend(), [&](const char c) {
-        disk_map.push_back(static_cast<uint32_t>(c - '0'));
-    });
+    disk_map.reserve(fs::file_size(ws_path));
+    std::array<char, 1U << 16U> chunk;
+    while(ifs.read(chunk.data(), chunk.size()) || ifs.gcount() > 0) {
+        const std::streamsize chunk_sz = ifs.gcount();
+        for(std::streamsize i = 0; i < chunk_sz; ++i) {
+            const char c = chunk[i];
+            if(c == '\n' || c == '\r')
+                return disk_map;
+            if(c < '0' || c > '9')
+                throw std::runtime_error(std::format("Invalid disk map digit '{}'", c));
+            disk_map.push_back(static_cast<char>(c - '0'));
+        }
+    }
     return disk_map;
 }